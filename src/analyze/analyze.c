@@ -106,6 +106,12 @@ struct boot_times {
         usec_t initrd_generators_finish_time;
         usec_t initrd_unitsload_start_time;
         usec_t initrd_unitsload_finish_time;
+        usec_t reload_start_time;
+        usec_t reload_generators_start_time;
+        usec_t reload_generators_finish_time;
+        usec_t reload_unitsload_start_time;
+        usec_t reload_unitsload_finish_time;
+        usec_t reload_finish_time;
 
         /*
          * If we're analyzing the user instance, all timestamps will be offset
@@ -250,6 +256,12 @@ static int acquire_boot_times(sd_bus *bus, struct boot_times **bt) {
                 { "InitRDGeneratorsFinishTimestampMonotonic", "t", NULL, offsetof(struct boot_times, initrd_generators_finish_time) },
                 { "InitRDUnitsLoadStartTimestampMonotonic",   "t", NULL, offsetof(struct boot_times, initrd_unitsload_start_time)   },
                 { "InitRDUnitsLoadFinishTimestampMonotonic",  "t", NULL, offsetof(struct boot_times, initrd_unitsload_finish_time)  },
+                { "ReloadStartTimestampMonotonic",            "t", NULL, offsetof(struct boot_times, reload_start_time)             },
+                { "ReloadGeneratorsStartTimestampMonotonic",  "t", NULL, offsetof(struct boot_times, reload_generators_start_time)  },
+                { "ReloadGeneratorsFinishTimestampMonotonic", "t", NULL, offsetof(struct boot_times, reload_generators_finish_time) },
+                { "ReloadUnitsLoadStartTimestampMonotonic",   "t", NULL, offsetof(struct boot_times, reload_unitsload_start_time)   },
+                { "ReloadUnitsLoadFinishTimestampMonotonic",  "t", NULL, offsetof(struct boot_times, reload_unitsload_finish_time)  },
+                { "ReloadFinishTimestampMonotonic",           "t", NULL, offsetof(struct boot_times, reload_finish_time)            },
                 {},
         };
         _cleanup_(sd_bus_error_free) sd_bus_error error = SD_BUS_ERROR_NULL;
@@ -553,6 +565,44 @@ static int pretty_boot_time(sd_bus *bus, char **_buf) {
         else if (!unit_id)
                 size = strpcpyf(&ptr, size, "\ncould not find default.target");
 
+        /* Older managers don't report the reload phases; with those, or if no reload happened yet, all are zero.
+         * The generators run after the serialization, except with ReloadIfChanged(), where they run first to
+         * find out whether anything changed. Hence, count whatever is outside of the other phases as
+         * serialization. */
+        if (t->reload_finish_time > t->reload_start_time &&
+            t->reload_generators_start_time >= t->reload_start_time &&
+            t->reload_generators_finish_time >= t->reload_generators_start_time &&
+            t->reload_unitsload_start_time >= t->reload_generators_finish_time &&
+            t->reload_unitsload_finish_time >= t->reload_unitsload_start_time &&
+            t->reload_finish_time >= t->reload_unitsload_finish_time) {
+                usec_t total, generators, units_load, coldplug;
+
+                total = t->reload_finish_time - t->reload_start_time;
+                generators = t->reload_generators_finish_time - t->reload_generators_start_time;
+                units_load = t->reload_unitsload_finish_time - t->reload_unitsload_start_time;
+                coldplug = t->reload_finish_time - t->reload_unitsload_finish_time;
+
+                if (t->reload_unitsload_start_time == t->reload_finish_time) {
+                        /* ReloadIfChanged() found nothing changed, only the generators were run */
+                        size = strpcpyf(&ptr, size, "\nLast reload skipped after %s (generators) + ",
+                                        format_timespan(ts, sizeof(ts), generators, USEC_PER_MSEC));
+                        size = strpcpyf(&ptr, size, "%s (unit file check) ",
+                                        format_timespan(ts, sizeof(ts), total - generators, USEC_PER_MSEC));
+                } else {
+                        size = strpcpyf(&ptr, size, "\nLast reload finished in %s (serialization) + ",
+                                        format_timespan(ts, sizeof(ts), total - generators - units_load - coldplug, USEC_PER_MSEC));
+                        size = strpcpyf(&ptr, size, "%s (generators) + ",
+                                        format_timespan(ts, sizeof(ts), generators, USEC_PER_MSEC));
+                        size = strpcpyf(&ptr, size, "%s (units load) + ",
+                                        format_timespan(ts, sizeof(ts), units_load, USEC_PER_MSEC));
+                        size = strpcpyf(&ptr, size, "%s (coldplug) ",
+                                        format_timespan(ts, sizeof(ts), coldplug, USEC_PER_MSEC));
+                }
+
+                size = strpcpyf(&ptr, size, "= %s",
+                                format_timespan(ts, sizeof(ts), total, USEC_PER_MSEC));
+        }
+
         ptr = strdup(buf);
         if (!ptr)
                 return log_oom();
@@ -22,6 +22,7 @@
 #include "fs-util.h"
 #include "io-util.h"
 #include "macro.h"
+#include "memory-util.h"
 #include "missing.h"
 #include "mountpoint-util.h"
 #include "stat-util.h"
@@ -86,6 +87,52 @@ static int fd_is_nonblock_pipe(int fd) {
         return FLAGS_SET(flags, O_NONBLOCK) ? FD_IS_NONBLOCKING_PIPE : FD_IS_BLOCKING_PIPE;
 }
 
+static size_t zero_run(const uint8_t *p, size_t n, bool *ret_zero) {
+        size_t ps, l, k;
+        bool zero;
+
+        assert(p);
+        assert(n > 0);
+        assert(ret_zero);
+
+        /* Returns the length of the run of pages at the beginning of the buffer that are either all zero
+         * bytes or all contain at least some non-zero data, and which of the two it is. */
+
+        ps = page_size();
+        l = MIN(n, ps);
+        zero = memeqzero(p, l);
+
+        while (l < n) {
+                k = MIN(n - l, ps);
+                if (memeqzero(p + l, k) != zero)
+                        break;
+
+                l += k;
+        }
+
+        *ret_zero = zero;
+        return l;
+}
+
+static int finish_sparse(int fdt, bool hole) {
+        off_t o;
+
+        /* If the last thing we did was skipping over a hole, make sure the file actually extends to the
+         * current offset. */
+
+        if (!hole)
+                return 0;
+
+        o = lseek(fdt, 0, SEEK_CUR);
+        if (o < 0)
+                return -errno;
+
+        if (ftruncate(fdt, o) < 0)
+                return -errno;
+
+        return 0;
+}
+
 int copy_bytes_full(
                 int fdf, int fdt,
                 uint64_t max_bytes,
@@ -95,7 +142,7 @@ int copy_bytes_full(
                 copy_progress_bytes_t progress,
                 void *userdata) {
 
-        bool try_cfr = true, try_sendfile = true, try_splice = true;
+        bool try_cfr = true, try_sendfile = true, try_splice = true, hole = false;
         int r, nonblock_pipe = -1;
         size_t m = SSIZE_MAX; /* that is the maximum that sendfile and c_f_r accept */
 
@@ -168,11 +215,21 @@ int copy_bytes_full(
                 }
         }
 
+        /* The in-kernel copy operations don't know how to leave holes, so for sparse copies we have to look
+         * at the data ourselves. */
+        if (copy_flags & COPY_SPARSE)
+                try_cfr = try_sendfile = try_splice = false;
+
         for (;;) {
                 ssize_t n;
 
-                if (max_bytes <= 0)
+                if (max_bytes <= 0) {
+                        r = finish_sparse(fdt, hole);
+                        if (r < 0)
+                                return r;
+
                         return 1; /* return > 0 if we hit the max_bytes limit */
+                }
 
                 if (max_bytes != UINT64_MAX && m > max_bytes)
                         m = max_bytes;
@@ -282,7 +339,16 @@ int copy_bytes_full(
                         do {
                                 ssize_t k;
 
-                                k = write(fdt, p, z);
+                                if (copy_flags & COPY_SPARSE) {
+                                        size_t l;
+
+                                        l = zero_run(p, z, &hole);
+                                        if (hole)
+                                                k = lseek(fdt, l, SEEK_CUR) < 0 ? -1 : (ssize_t) l;
+                                        else
+                                                k = write(fdt, p, l);
+                                } else
+                                        k = write(fdt, p, z);
                                 if (k < 0) {
                                         r = -errno;
 
@@ -327,6 +393,10 @@ int copy_bytes_full(
                 m = MAX(MIN(COPY_BUFFER_SIZE, max_bytes), m - n);
         }
 
+        r = finish_sparse(fdt, hole);
+        if (r < 0)
+                return r;
+
         return 0; /* return 0 if we hit EOF earlier than the size limit */
 }
 
@@ -727,6 +727,27 @@ static EndOfLineMarker categorize_eol(char c, ReadLineFlags flags) {
 
 DEFINE_TRIVIAL_CLEANUP_FUNC(FILE*, funlockfile);
 
+static int safe_fgetc_unlocked(FILE *f, char *ret) {
+        int k;
+
+        /* Like safe_fgetc(), but expects the caller to hold the stream lock already. This is the inner loop of
+         * read_line_full(), which is hit once for every byte of every serialization and configuration file we read,
+         * hence avoid taking the lock again for each byte. */
+
+        errno = 0;
+        k = getc_unlocked(f);
+        if (k == EOF) {
+                if (ferror_unlocked(f))
+                        return errno > 0 ? -errno : -EIO;
+
+                *ret = 0;
+                return 0;
+        }
+
+        *ret = k;
+        return 1;
+}
+
 int read_line_full(FILE *f, size_t limit, ReadLineFlags flags, char **ret) {
         size_t n = 0, allocated = 0, count = 0;
         _cleanup_free_ char *buffer = NULL;
@@ -778,7 +799,7 @@ int read_line_full(FILE *f, size_t limit, ReadLineFlags flags, char **ret) {
                         if (count >= INT_MAX) /* We couldn't return the counter anymore as "int", hence refuse this */
                                 return -ENOBUFS;
 
-                        r = safe_fgetc(f, &c);
+                        r = safe_fgetc_unlocked(f, &c);
                         if (r < 0)
                                 return r;
                         if (r == 0) /* EOF is definitely EOL */
@@ -62,10 +62,118 @@ bool unit_has_host_root_cgroup(Unit *u) {
         return unit_has_name(u, SPECIAL_ROOT_SLICE);
 }
 
-static int set_attribute_and_warn(Unit *u, const char *controller, const char *attribute, const char *value) {
+DEFINE_PRIVATE_HASH_OPS_FULL(cgroup_attribute_hash_ops, char, string_hash_func, string_compare_func, free,
+                             char, free);
+
+char *cgroup_attribute_cache_key(const char *attribute, const char *value) {
+        _cleanup_free_ char *device = NULL;
+        size_t n;
+
+        /* Per-device attributes such as io.max or blkio.weight_device take one "MAJOR:MINOR …" line per write, and
+         * each of those sets a different value, hence key the cache by the device too. */
+
+        n = strcspn(value, WHITESPACE);
+        if (!memchr(value, ':', n))
+                return strdup(attribute);
+
+        device = strndup(value, n);
+        if (!device)
+                return NULL;
+
+        return strjoin(attribute, " ", device);
+}
+
+void unit_cgroup_attribute_cache_update(Unit *u, const char *key, const char *value) {
+        _cleanup_free_ char *k = NULL, *v = NULL;
+        char *old_key, *old_value;
+        int r;
+
+        assert(u);
+        assert(key);
+
+        /* Forgets what we previously wrote to the attribute, and remembers the new value if there is one. This is a
+         * cache only, hence if we fail to allocate we'll simply write the attribute again the next time. */
+
+        old_value = hashmap_remove2(u->cgroup_attribute_cache, key, (void**) &old_key);
+        free(old_key);
+        free(old_value);
+
+        if (!value)
+                return;
+
+        k = strdup(key);
+        v = strdup(value);
+        if (!k || !v)
+                return;
+
+        r = hashmap_ensure_allocated(&u->cgroup_attribute_cache, &cgroup_attribute_hash_ops);
+        if (r < 0)
+                return;
+
+        r = hashmap_put(u->cgroup_attribute_cache, k, v);
+        if (r < 0)
+                return;
+
+        TAKE_PTR(k);
+        TAKE_PTR(v);
+}
+
+static bool cgroup_attribute_in_mask(const char *key, CGroupMask mask) {
+        CGroupController c;
+
+        /* Attribute names are prefixed by the name of the controller they belong to. Attributes we cannot map to a
+         * controller are always considered part of the mask. */
+
+        for (c = 0; c < _CGROUP_CONTROLLER_MAX; c++) {
+                const char *e;
+
+                e = startswith(key, cgroup_controller_to_string(c));
+                if (e && *e == '.')
+                        return FLAGS_SET(mask, CGROUP_CONTROLLER_TO_MASK(c));
+        }
+
+        return true;
+}
+
+void unit_cgroup_attribute_cache_flush(Unit *u, CGroupMask mask) {
+        char *key, *value;
+        Iterator i;
+
+        assert(u);
+
+        /* Forgets the cached values of all attributes of the specified controllers, so that they are written again
+         * on the next realization. */
+
+        HASHMAP_FOREACH_KEY(value, key, u->cgroup_attribute_cache, i) {
+                if (!cgroup_attribute_in_mask(key, mask))
+                        continue;
+
+                (void) hashmap_remove(u->cgroup_attribute_cache, key);
+                free(key);
+                free(value);
+        }
+}
+
+int unit_set_cgroup_attribute(Unit *u, const char *controller, const char *attribute, const char *value) {
+        _cleanup_free_ char *key = NULL;
         int r;
 
+        /* Skip the write if we already wrote the very same value to this attribute of this cgroup. Realizing a cgroup
+         * applies all attributes of all its controllers, even if only the controllers enabled for its children
+         * changed, hence this saves a lot of writes to cgroupfs when many units are started in the same slice. */
+        key = cgroup_attribute_cache_key(attribute, value);
+        if (key && streq_ptr(hashmap_get(u->cgroup_attribute_cache, key), value)) {
+                u->manager->n_cgroup_attribute_writes_skipped++;
+                return 0;
+        }
+
         r = cg_set_attribute(controller, u->cgroup_path, attribute, value);
+        u->manager->n_cgroup_attribute_writes++;
+
+        /* If the write failed we don't know what the attribute is set to now, hence just forget about it then */
+        if (key)
+                unit_cgroup_attribute_cache_update(u, key, r >= 0 ? value : NULL);
+
         if (r < 0)
                 log_unit_full(u, LOG_LEVEL_CGROUP_WRITE(r), r, "Failed to set '%s' attribute on '%s' to '%.*s': %m",
                               strna(attribute), isempty(u->cgroup_path) ? "/" : u->cgroup_path, (int) strcspn(value, NEWLINE), value);
@@ -699,7 +807,7 @@ static void cgroup_apply_unified_cpu_weight(Unit *u, uint64_t weight) {
         char buf[DECIMAL_STR_MAX(uint64_t) + 2];
 
         xsprintf(buf, "%" PRIu64 "\n", weight);
-        (void) set_attribute_and_warn(u, "cpu", "cpu.weight", buf);
+        (void) unit_set_cgroup_attribute(u, "cpu", "cpu.weight", buf);
 }
 
 static void cgroup_apply_unified_cpu_quota(Unit *u, usec_t quota, usec_t period) {
@@ -711,14 +819,14 @@ static void cgroup_apply_unified_cpu_quota(Unit *u, usec_t quota, usec_t period)
                          MAX(quota * period / USEC_PER_SEC, USEC_PER_MSEC), period);
         else
                 xsprintf(buf, "max " USEC_FMT "\n", period);
-        (void) set_attribute_and_warn(u, "cpu", "cpu.max", buf);
+        (void) unit_set_cgroup_attribute(u, "cpu", "cpu.max", buf);
 }
 
 static void cgroup_apply_legacy_cpu_shares(Unit *u, uint64_t shares) {
         char buf[DECIMAL_STR_MAX(uint64_t) + 2];
 
         xsprintf(buf, "%" PRIu64 "\n", shares);
-        (void) set_attribute_and_warn(u, "cpu", "cpu.shares", buf);
+        (void) unit_set_cgroup_attribute(u, "cpu", "cpu.shares", buf);
 }
 
 static void cgroup_apply_legacy_cpu_quota(Unit *u, usec_t quota, usec_t period) {
@@ -727,13 +835,13 @@ static void cgroup_apply_legacy_cpu_quota(Unit *u, usec_t quota, usec_t period)
         period = cgroup_cpu_adjust_period_and_log(u, period, quota);
 
         xsprintf(buf, USEC_FMT "\n", period);
-        (void) set_attribute_and_warn(u, "cpu", "cpu.cfs_period_us", buf);
+        (void) unit_set_cgroup_attribute(u, "cpu", "cpu.cfs_period_us", buf);
 
         if (quota != USEC_INFINITY) {
                 xsprintf(buf, USEC_FMT "\n", MAX(quota * period / USEC_PER_SEC, USEC_PER_MSEC));
-                (void) set_attribute_and_warn(u, "cpu", "cpu.cfs_quota_us", buf);
+                (void) unit_set_cgroup_attribute(u, "cpu", "cpu.cfs_quota_us", buf);
         } else
-                (void) set_attribute_and_warn(u, "cpu", "cpu.cfs_quota_us", "-1\n");
+                (void) unit_set_cgroup_attribute(u, "cpu", "cpu.cfs_quota_us", "-1\n");
 }
 
 static uint64_t cgroup_cpu_shares_to_weight(uint64_t shares) {
@@ -803,7 +911,7 @@ static void cgroup_apply_io_device_weight(Unit *u, const char *dev_path, uint64_
                 return;
 
         xsprintf(buf, "%u:%u %" PRIu64 "\n", major(dev), minor(dev), io_weight);
-        (void) set_attribute_and_warn(u, "io", "io.weight", buf);
+        (void) unit_set_cgroup_attribute(u, "io", "io.weight", buf);
 }
 
 static void cgroup_apply_blkio_device_weight(Unit *u, const char *dev_path, uint64_t blkio_weight) {
@@ -816,7 +924,7 @@ static void cgroup_apply_blkio_device_weight(Unit *u, const char *dev_path, uint
                 return;
 
         xsprintf(buf, "%u:%u %" PRIu64 "\n", major(dev), minor(dev), blkio_weight);
-        (void) set_attribute_and_warn(u, "blkio", "blkio.weight_device", buf);
+        (void) unit_set_cgroup_attribute(u, "blkio", "blkio.weight_device", buf);
 }
 
 static void cgroup_apply_io_device_latency(Unit *u, const char *dev_path, usec_t target) {
@@ -833,7 +941,7 @@ static void cgroup_apply_io_device_latency(Unit *u, const char *dev_path, usec_t
         else
                 xsprintf(buf, "%u:%u target=max\n", major(dev), minor(dev));
 
-        (void) set_attribute_and_warn(u, "io", "io.latency", buf);
+        (void) unit_set_cgroup_attribute(u, "io", "io.latency", buf);
 }
 
 static void cgroup_apply_io_device_limit(Unit *u, const char *dev_path, uint64_t *limits) {
@@ -856,7 +964,7 @@ static void cgroup_apply_io_device_limit(Unit *u, const char *dev_path, uint64_t
         xsprintf(buf, "%u:%u rbps=%s wbps=%s riops=%s wiops=%s\n", major(dev), minor(dev),
                  limit_bufs[CGROUP_IO_RBPS_MAX], limit_bufs[CGROUP_IO_WBPS_MAX],
                  limit_bufs[CGROUP_IO_RIOPS_MAX], limit_bufs[CGROUP_IO_WIOPS_MAX]);
-        (void) set_attribute_and_warn(u, "io", "io.max", buf);
+        (void) unit_set_cgroup_attribute(u, "io", "io.max", buf);
 }
 
 static void cgroup_apply_blkio_device_limit(Unit *u, const char *dev_path, uint64_t rbps, uint64_t wbps) {
@@ -869,10 +977,10 @@ static void cgroup_apply_blkio_device_limit(Unit *u, const char *dev_path, uint6
                 return;
 
         sprintf(buf, "%u:%u %" PRIu64 "\n", major(dev), minor(dev), rbps);
-        (void) set_attribute_and_warn(u, "blkio", "blkio.throttle.read_bps_device", buf);
+        (void) unit_set_cgroup_attribute(u, "blkio", "blkio.throttle.read_bps_device", buf);
 
         sprintf(buf, "%u:%u %" PRIu64 "\n", major(dev), minor(dev), wbps);
-        (void) set_attribute_and_warn(u, "blkio", "blkio.throttle.write_bps_device", buf);
+        (void) unit_set_cgroup_attribute(u, "blkio", "blkio.throttle.write_bps_device", buf);
 }
 
 static bool cgroup_context_has_unified_memory_config(CGroupContext *c) {
@@ -885,7 +993,7 @@ static void cgroup_apply_unified_memory_limit(Unit *u, const char *file, uint64_
         if (v != CGROUP_LIMIT_MAX)
                 xsprintf(buf, "%" PRIu64 "\n", v);
 
-        (void) set_attribute_and_warn(u, "memory", file, buf);
+        (void) unit_set_cgroup_attribute(u, "memory", file, buf);
 }
 
 static void cgroup_apply_firewall(Unit *u) {
@@ -1001,7 +1109,7 @@ static void cgroup_context_apply(
                         weight = CGROUP_WEIGHT_DEFAULT;
 
                 xsprintf(buf, "default %" PRIu64 "\n", weight);
-                (void) set_attribute_and_warn(u, "io", "io.weight", buf);
+                (void) unit_set_cgroup_attribute(u, "io", "io.weight", buf);
 
                 if (has_io) {
                         CGroupIODeviceLatency *latency;
@@ -1074,7 +1182,7 @@ static void cgroup_context_apply(
                                 weight = CGROUP_BLKIO_WEIGHT_DEFAULT;
 
                         xsprintf(buf, "%" PRIu64 "\n", weight);
-                        (void) set_attribute_and_warn(u, "blkio", "blkio.weight", buf);
+                        (void) unit_set_cgroup_attribute(u, "blkio", "blkio.weight", buf);
 
                         if (has_io) {
                                 CGroupIODeviceWeight *w;
@@ -1156,7 +1264,7 @@ static void cgroup_context_apply(
                         else
                                 xsprintf(buf, "%" PRIu64 "\n", val);
 
-                        (void) set_attribute_and_warn(u, "memory", "memory.limit_in_bytes", buf);
+                        (void) unit_set_cgroup_attribute(u, "memory", "memory.limit_in_bytes", buf);
                 }
         }
 
@@ -1281,9 +1389,9 @@ static void cgroup_context_apply(
                                 char buf[DECIMAL_STR_MAX(uint64_t) + 2];
 
                                 sprintf(buf, "%" PRIu64 "\n", c->tasks_max);
-                                (void) set_attribute_and_warn(u, "pids", "pids.max", buf);
+                                (void) unit_set_cgroup_attribute(u, "pids", "pids.max", buf);
                         } else
-                                (void) set_attribute_and_warn(u, "pids", "pids.max", "max\n");
+                                (void) unit_set_cgroup_attribute(u, "pids", "pids.max", "max\n");
                 }
         }
 
@@ -1723,6 +1831,13 @@ static int unit_create_cgroup(
                 u->cgroup_enabled_mask = result_mask;
         }
 
+        /* Attributes of controllers we weren't realized for yet start out with the kernel defaults, hence forget what
+         * we might have written to them before. */
+        if (created || !u->cgroup_realized)
+                unit_cgroup_attribute_cache_flush(u, _CGROUP_MASK_ALL);
+        else
+                unit_cgroup_attribute_cache_flush(u, target_mask & ~u->cgroup_realized_mask);
+
         /* Keep track that this is now realized */
         u->cgroup_realized = true;
         u->cgroup_realized_mask = target_mask;
@@ -2123,15 +2238,61 @@ static int unit_realize_cgroup_now(Unit *u, ManagerState state) {
         return 0;
 }
 
+static void manager_dispatch_cgroup_siblings_queue(Manager *m) {
+        Unit *slice;
+
+        assert(m);
+
+        /* Goes through the members of each slice queued by unit_add_siblings_to_cgroup_realize_queue() once, and
+         * enqueues those which need to be realized. */
+
+        while ((slice = m->cgroup_siblings_queue)) {
+                Iterator i;
+                Unit *u;
+                void *v;
+
+                assert(slice->in_cgroup_siblings_queue);
+
+                LIST_REMOVE(cgroup_siblings_queue, m->cgroup_siblings_queue, slice);
+                slice->in_cgroup_siblings_queue = false;
+
+                HASHMAP_FOREACH_KEY(v, u, slice->dependencies[UNIT_BEFORE], i) {
+                        /* Skip units that have a dependency on the slice
+                         * but aren't actually in it. */
+                        if (UNIT_DEREF(u->slice) != slice)
+                                continue;
+
+                        /* No point in doing cgroup application for units
+                         * without active processes. */
+                        if (UNIT_IS_INACTIVE_OR_FAILED(unit_active_state(u)))
+                                continue;
+
+                        /* If the unit doesn't need any new controllers
+                         * and has current ones realized, it doesn't need
+                         * any changes. */
+                        if (unit_has_mask_realized(u,
+                                                   unit_get_target_mask(u),
+                                                   unit_get_enable_mask(u)))
+                                continue;
+
+                        unit_add_to_cgroup_realize_queue(u);
+                }
+        }
+}
+
 unsigned manager_dispatch_cgroup_realize_queue(Manager *m) {
+        unsigned n = 0, writes, skipped;
         ManagerState state;
-        unsigned n = 0;
         Unit *i;
         int r;
 
         assert(m);
 
+        manager_dispatch_cgroup_siblings_queue(m);
+
         state = manager_state(m);
+        writes = m->n_cgroup_attribute_writes;
+        skipped = m->n_cgroup_attribute_writes_skipped;
 
         while ((i = m->cgroup_realize_queue)) {
                 assert(i->in_cgroup_realize_queue);
@@ -2149,44 +2310,32 @@ unsigned manager_dispatch_cgroup_realize_queue(Manager *m) {
                 n++;
         }
 
+        if (n > 0)
+                log_debug("Realized cgroups of %u queued units, with %u cgroup attribute writes (%u unchanged attributes skipped).",
+                          n, m->n_cgroup_attribute_writes - writes, m->n_cgroup_attribute_writes_skipped - skipped);
+
         return n;
 }
 
 static void unit_add_siblings_to_cgroup_realize_queue(Unit *u) {
         Unit *slice;
 
-        /* This adds the siblings of the specified unit and the
-         * siblings of all parent units to the cgroup queue. (But
-         * neither the specified unit itself nor the parents.) */
-
-        while ((slice = UNIT_DEREF(u->slice))) {
-                Iterator i;
-                Unit *m;
-                void *v;
-
-                HASHMAP_FOREACH_KEY(v, m, u->dependencies[UNIT_BEFORE], i) {
-                        /* Skip units that have a dependency on the slice
-                         * but aren't actually in it. */
-                        if (UNIT_DEREF(m->slice) != slice)
-                                continue;
-
-                        /* No point in doing cgroup application for units
-                         * without active processes. */
-                        if (UNIT_IS_INACTIVE_OR_FAILED(unit_active_state(m)))
-                                continue;
+        /* This arranges for the siblings of the specified unit and
+         * the siblings of all parent units to be added to the cgroup
+         * queue. (But neither the specified unit itself nor the
+         * parents.) The members of each slice are only looked at
+         * once when the queue is dispatched, no matter how many of
+         * them are started until then, instead of once for each of
+         * them. */
 
-                        /* If the unit doesn't need any new controllers
-                         * and has current ones realized, it doesn't need
-                         * any changes. */
-                        if (unit_has_mask_realized(m,
-                                                   unit_get_target_mask(m),
-                                                   unit_get_enable_mask(m)))
-                                continue;
+        for (slice = UNIT_DEREF(u->slice); slice; slice = UNIT_DEREF(slice->slice)) {
 
-                        unit_add_to_cgroup_realize_queue(m);
-                }
+                /* If this slice is queued already, so are its parents */
+                if (slice->in_cgroup_siblings_queue)
+                        break;
 
-                u = slice;
+                LIST_PREPEND(cgroup_siblings_queue, u->manager->cgroup_siblings_queue, slice);
+                slice->in_cgroup_siblings_queue = true;
         }
 }
 
@@ -2232,6 +2381,8 @@ void unit_release_cgroup(Unit *u) {
                 (void) hashmap_remove(u->manager->cgroup_inotify_wd_unit, INT_TO_PTR(u->cgroup_inotify_wd));
                 u->cgroup_inotify_wd = -1;
         }
+
+        u->cgroup_attribute_cache = hashmap_free(u->cgroup_attribute_cache);
 }
 
 void unit_prune_cgroup(Unit *u) {
@@ -3049,6 +3200,9 @@ void unit_invalidate_cgroup(Unit *u, CGroupMask m) {
         if (FLAGS_SET(u->cgroup_invalidated_mask, m)) /* NOP? */
                 return;
 
+        /* Make sure the attributes are actually written again, even if we think they didn't change */
+        unit_cgroup_attribute_cache_flush(u, m);
+
         u->cgroup_invalidated_mask |= m;
         unit_add_to_cgroup_realize_queue(u);
 }
@@ -212,6 +212,12 @@ bool unit_has_host_root_cgroup(Unit *u);
 
 int manager_notify_cgroup_empty(Manager *m, const char *group);
 
+int unit_set_cgroup_attribute(Unit *u, const char *controller, const char *attribute, const char *value);
+
+char *cgroup_attribute_cache_key(const char *attribute, const char *value);
+void unit_cgroup_attribute_cache_update(Unit *u, const char *key, const char *value);
+void unit_cgroup_attribute_cache_flush(Unit *u, CGroupMask mask);
+
 void unit_invalidate_cgroup(Unit *u, CGroupMask m);
 void unit_invalidate_cgroup_bpf(Unit *u);
 
@@ -1053,6 +1053,94 @@ static int method_list_units_by_patterns(sd_bus_message *message, void *userdata
         return list_units_filtered(message, userdata, error, states, patterns);
 }
 
+static int reply_unit_accounting(sd_bus_message *reply, Unit *u) {
+        uint64_t memory = (uint64_t) -1, tasks = (uint64_t) -1, ip[_CGROUP_IP_ACCOUNTING_METRIC_MAX];
+        nsec_t cpu = (nsec_t) -1;
+        CGroupIPAccountingMetric metric;
+
+        assert(reply);
+        assert(u);
+
+        /* Same values as the CPUUsageNSec=, MemoryCurrent=, TasksCurrent= and IP*= unit properties, with
+         * (uint64_t) -1 if not available */
+
+        (void) unit_get_cpu_usage(u, &cpu);
+        (void) unit_get_memory_current(u, &memory);
+        (void) unit_get_tasks_current(u, &tasks);
+
+        for (metric = 0; metric < _CGROUP_IP_ACCOUNTING_METRIC_MAX; metric++) {
+                ip[metric] = (uint64_t) -1;
+                (void) unit_get_ip_accounting(u, metric, ip + metric);
+        }
+
+        return sd_bus_message_append(
+                        reply, "(sttttttt)",
+                        u->id,
+                        cpu,
+                        memory,
+                        tasks,
+                        ip[CGROUP_IP_INGRESS_BYTES],
+                        ip[CGROUP_IP_INGRESS_PACKETS],
+                        ip[CGROUP_IP_EGRESS_BYTES],
+                        ip[CGROUP_IP_EGRESS_PACKETS]);
+}
+
+static int method_get_units_accounting(sd_bus_message *message, void *userdata, sd_bus_error *error) {
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
+        _cleanup_strv_free_ char **patterns = NULL;
+        Manager *m = userdata;
+        const char *k;
+        Iterator i;
+        Unit *u;
+        int r;
+
+        assert(message);
+        assert(m);
+
+        /* Anyone can call this method */
+
+        r = mac_selinux_access_check(message, "status", error);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_read_strv(message, &patterns);
+        if (r < 0)
+                return r;
+
+        /* Returns the resource accounting data of all units with a cgroup in one go, so that monitoring tools don't
+         * need to issue a property query for each metric of each unit. */
+
+        r = sd_bus_message_new_method_return(message, &reply);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_open_container(reply, 'a', "(sttttttt)");
+        if (r < 0)
+                return r;
+
+        HASHMAP_FOREACH_KEY(u, k, m->units, i) {
+                if (k != u->id)
+                        continue;
+
+                if (!UNIT_HAS_CGROUP_CONTEXT(u) || !u->cgroup_path)
+                        continue;
+
+                if (!strv_isempty(patterns) &&
+                    !strv_fnmatch_or_empty(patterns, u->id, FNM_NOESCAPE))
+                        continue;
+
+                r = reply_unit_accounting(reply, u);
+                if (r < 0)
+                        return r;
+        }
+
+        r = sd_bus_message_close_container(reply);
+        if (r < 0)
+                return r;
+
+        return sd_bus_send(NULL, reply, NULL);
+}
+
 static int method_list_jobs(sd_bus_message *message, void *userdata, sd_bus_error *error) {
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
         Manager *m = userdata;
@@ -1107,12 +1195,12 @@ static int method_list_jobs(sd_bus_message *message, void *userdata, sd_bus_erro
         return sd_bus_send(NULL, reply, NULL);
 }
 
-static int method_subscribe(sd_bus_message *message, void *userdata, sd_bus_error *error) {
-        Manager *m = userdata;
+static int subscribe_impl(sd_bus_message *message, Manager *m, sd_bus_track **t, sd_bus_error *error) {
         int r;
 
         assert(message);
         assert(m);
+        assert(t);
 
         /* Anyone can call this method */
 
@@ -1125,13 +1213,13 @@ static int method_subscribe(sd_bus_message *message, void *userdata, sd_bus_erro
                 /* Note that direct bus connection subscribe by
                  * default, we only track peers on the API bus here */
 
-                if (!m->subscribed) {
-                        r = sd_bus_track_new(sd_bus_message_get_bus(message), &m->subscribed, NULL, NULL);
+                if (!*t) {
+                        r = sd_bus_track_new(sd_bus_message_get_bus(message), t, NULL, NULL);
                         if (r < 0)
                                 return r;
                 }
 
-                r = sd_bus_track_add_sender(m->subscribed, message);
+                r = sd_bus_track_add_sender(*t, message);
                 if (r < 0)
                         return r;
                 if (r == 0)
@@ -1141,8 +1229,7 @@ static int method_subscribe(sd_bus_message *message, void *userdata, sd_bus_erro
         return sd_bus_reply_method_return(message, NULL);
 }
 
-static int method_unsubscribe(sd_bus_message *message, void *userdata, sd_bus_error *error) {
-        Manager *m = userdata;
+static int unsubscribe_impl(sd_bus_message *message, Manager *m, sd_bus_track *t, sd_bus_error *error) {
         int r;
 
         assert(message);
@@ -1155,7 +1242,7 @@ static int method_unsubscribe(sd_bus_message *message, void *userdata, sd_bus_er
                 return r;
 
         if (sd_bus_message_get_bus(message) == m->api_bus) {
-                r = sd_bus_track_remove_sender(m->subscribed, message);
+                r = sd_bus_track_remove_sender(t, message);
                 if (r < 0)
                         return r;
                 if (r == 0)
@@ -1165,6 +1252,30 @@ static int method_unsubscribe(sd_bus_message *message, void *userdata, sd_bus_er
         return sd_bus_reply_method_return(message, NULL);
 }
 
+static int method_subscribe(sd_bus_message *message, void *userdata, sd_bus_error *error) {
+        Manager *m = userdata;
+
+        return subscribe_impl(message, m, &m->subscribed, error);
+}
+
+static int method_unsubscribe(sd_bus_message *message, void *userdata, sd_bus_error *error) {
+        Manager *m = userdata;
+
+        return unsubscribe_impl(message, m, m->subscribed, error);
+}
+
+static int method_subscribe_batched(sd_bus_message *message, void *userdata, sd_bus_error *error) {
+        Manager *m = userdata;
+
+        return subscribe_impl(message, m, &m->subscribed_batched, error);
+}
+
+static int method_unsubscribe_batched(sd_bus_message *message, void *userdata, sd_bus_error *error) {
+        Manager *m = userdata;
+
+        return unsubscribe_impl(message, m, m->subscribed_batched, error);
+}
+
 static int dump_impl(sd_bus_message *message, void *userdata, sd_bus_error *error, int (*reply)(sd_bus_message *, char *)) {
         _cleanup_free_ char *dump = NULL;
         Manager *m = userdata;
@@ -1277,6 +1388,7 @@ static int method_reload(sd_bus_message *message, void *userdata, sd_bus_error *
         if (r < 0)
                 return r;
 
+        m->reload_if_changed = streq(sd_bus_message_get_member(message), "ReloadIfChanged");
         m->objective = MANAGER_RELOAD;
 
         return 1;
@@ -2385,6 +2497,12 @@ const sd_bus_vtable bus_manager_vtable[] = {
         BUS_PROPERTY_DUAL_TIMESTAMP("InitRDGeneratorsFinishTimestamp", offsetof(Manager, timestamps[MANAGER_TIMESTAMP_INITRD_GENERATORS_FINISH]), SD_BUS_VTABLE_PROPERTY_CONST),
         BUS_PROPERTY_DUAL_TIMESTAMP("InitRDUnitsLoadStartTimestamp", offsetof(Manager, timestamps[MANAGER_TIMESTAMP_INITRD_UNITS_LOAD_START]), SD_BUS_VTABLE_PROPERTY_CONST),
         BUS_PROPERTY_DUAL_TIMESTAMP("InitRDUnitsLoadFinishTimestamp", offsetof(Manager, timestamps[MANAGER_TIMESTAMP_INITRD_UNITS_LOAD_FINISH]), SD_BUS_VTABLE_PROPERTY_CONST),
+        BUS_PROPERTY_DUAL_TIMESTAMP("ReloadStartTimestamp", offsetof(Manager, timestamps[MANAGER_TIMESTAMP_RELOAD_START]), 0),
+        BUS_PROPERTY_DUAL_TIMESTAMP("ReloadGeneratorsStartTimestamp", offsetof(Manager, timestamps[MANAGER_TIMESTAMP_RELOAD_GENERATORS_START]), 0),
+        BUS_PROPERTY_DUAL_TIMESTAMP("ReloadGeneratorsFinishTimestamp", offsetof(Manager, timestamps[MANAGER_TIMESTAMP_RELOAD_GENERATORS_FINISH]), 0),
+        BUS_PROPERTY_DUAL_TIMESTAMP("ReloadUnitsLoadStartTimestamp", offsetof(Manager, timestamps[MANAGER_TIMESTAMP_RELOAD_UNITS_LOAD_START]), 0),
+        BUS_PROPERTY_DUAL_TIMESTAMP("ReloadUnitsLoadFinishTimestamp", offsetof(Manager, timestamps[MANAGER_TIMESTAMP_RELOAD_UNITS_LOAD_FINISH]), 0),
+        BUS_PROPERTY_DUAL_TIMESTAMP("ReloadFinishTimestamp", offsetof(Manager, timestamps[MANAGER_TIMESTAMP_RELOAD_FINISH]), 0),
         SD_BUS_WRITABLE_PROPERTY("LogLevel", "s", property_get_log_level, property_set_log_level, 0, 0),
         SD_BUS_WRITABLE_PROPERTY("LogTarget", "s", property_get_log_target, property_set_log_target, 0, 0),
         SD_BUS_PROPERTY("NNames", "u", property_get_hashmap_size, offsetof(Manager, units), 0),
@@ -2486,14 +2604,18 @@ const sd_bus_vtable bus_manager_vtable[] = {
         SD_BUS_METHOD("ListUnitsFiltered", "as", "a(ssssssouso)", method_list_units_filtered, SD_BUS_VTABLE_UNPRIVILEGED),
         SD_BUS_METHOD("ListUnitsByPatterns", "asas", "a(ssssssouso)", method_list_units_by_patterns, SD_BUS_VTABLE_UNPRIVILEGED),
         SD_BUS_METHOD("ListUnitsByNames", "as", "a(ssssssouso)", method_list_units_by_names, SD_BUS_VTABLE_UNPRIVILEGED),
+        SD_BUS_METHOD("GetUnitsAccounting", "as", "a(sttttttt)", method_get_units_accounting, SD_BUS_VTABLE_UNPRIVILEGED),
         SD_BUS_METHOD("ListJobs", NULL, "a(usssoo)", method_list_jobs, SD_BUS_VTABLE_UNPRIVILEGED),
         SD_BUS_METHOD("Subscribe", NULL, NULL, method_subscribe, SD_BUS_VTABLE_UNPRIVILEGED),
         SD_BUS_METHOD("Unsubscribe", NULL, NULL, method_unsubscribe, SD_BUS_VTABLE_UNPRIVILEGED),
+        SD_BUS_METHOD("SubscribeBatched", NULL, NULL, method_subscribe_batched, SD_BUS_VTABLE_UNPRIVILEGED),
+        SD_BUS_METHOD("UnsubscribeBatched", NULL, NULL, method_unsubscribe_batched, SD_BUS_VTABLE_UNPRIVILEGED),
         SD_BUS_METHOD("Dump", NULL, "s", method_dump, SD_BUS_VTABLE_UNPRIVILEGED),
         SD_BUS_METHOD("DumpByFileDescriptor", NULL, "h", method_dump_by_fd, SD_BUS_VTABLE_UNPRIVILEGED),
         SD_BUS_METHOD("CreateSnapshot", "sb", "o", method_refuse_snapshot, SD_BUS_VTABLE_UNPRIVILEGED|SD_BUS_VTABLE_HIDDEN),
         SD_BUS_METHOD("RemoveSnapshot", "s", NULL, method_refuse_snapshot, SD_BUS_VTABLE_UNPRIVILEGED|SD_BUS_VTABLE_HIDDEN),
         SD_BUS_METHOD("Reload", NULL, NULL, method_reload, SD_BUS_VTABLE_UNPRIVILEGED),
+        SD_BUS_METHOD("ReloadIfChanged", NULL, NULL, method_reload, SD_BUS_VTABLE_UNPRIVILEGED),
         SD_BUS_METHOD("Reexecute", NULL, NULL, method_reexecute, SD_BUS_VTABLE_UNPRIVILEGED),
         SD_BUS_METHOD("Exit", NULL, NULL, method_exit, 0),
         SD_BUS_METHOD("Reboot", NULL, NULL, method_reboot, SD_BUS_VTABLE_CAPABILITY(CAP_SYS_BOOT)),
@@ -2528,6 +2650,7 @@ const sd_bus_vtable bus_manager_vtable[] = {
 
         SD_BUS_SIGNAL("UnitNew", "so", 0),
         SD_BUS_SIGNAL("UnitRemoved", "so", 0),
+        SD_BUS_SIGNAL("UnitsChanged", "a(sssso)a(so)", 0),
         SD_BUS_SIGNAL("JobNew", "uos", 0),
         SD_BUS_SIGNAL("JobRemoved", "uoss", 0),
         SD_BUS_SIGNAL("StartupFinished", "tttttt", 0),
@@ -2630,3 +2753,207 @@ void bus_manager_send_change_signal(Manager *m) {
         if (r < 0)
                 log_debug_errno(r, "Failed to send manager change signal: %m");
 }
+
+/* How long to collect unit changes for before sending them out in one UnitsChanged signal to batched subscribers. The
+ * timer gets an explicit accuracy, as the default one of sd-event is larger than the window itself. */
+#define UNITS_CHANGED_BATCH_USEC (100 * USEC_PER_MSEC)
+#define UNITS_CHANGED_BATCH_ACCURACY_USEC (10 * USEC_PER_MSEC)
+
+static int send_units_changed(sd_bus *bus, Manager *m) {
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *message = NULL;
+        const char *id, *path;
+        Iterator i;
+        Unit *u;
+        int r;
+
+        assert(bus);
+        assert(m);
+
+        r = sd_bus_message_new_signal(bus, &message, "/org/freedesktop/systemd1", "org.freedesktop.systemd1.Manager", "UnitsChanged");
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_open_container(message, 'a', "(sssso)");
+        if (r < 0)
+                return r;
+
+        SET_FOREACH(u, m->dbus_batched_units, i) {
+                _cleanup_free_ char *p = NULL;
+
+                p = unit_dbus_path(u);
+                if (!p)
+                        return -ENOMEM;
+
+                r = sd_bus_message_append(
+                                message, "(sssso)",
+                                u->id,
+                                unit_load_state_to_string(u->load_state),
+                                unit_active_state_to_string(unit_active_state(u)),
+                                unit_sub_state_to_string(u),
+                                p);
+                if (r < 0)
+                        return r;
+        }
+
+        r = sd_bus_message_close_container(message);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_open_container(message, 'a', "(so)");
+        if (r < 0)
+                return r;
+
+        HASHMAP_FOREACH_KEY(path, id, m->dbus_batched_removed, i) {
+                r = sd_bus_message_append(message, "(so)", id, path);
+                if (r < 0)
+                        return r;
+        }
+
+        r = sd_bus_message_close_container(message);
+        if (r < 0)
+                return r;
+
+        return sd_bus_send(bus, message, NULL);
+}
+
+void bus_manager_flush_units_changed(Manager *m) {
+        int r;
+
+        assert(m);
+
+        if (set_isempty(m->dbus_batched_units) && hashmap_isempty(m->dbus_batched_removed))
+                return;
+
+        if (m->api_bus && sd_bus_track_count(m->subscribed_batched) > 0) {
+                r = send_units_changed(m->api_bus, m);
+                if (r < 0)
+                        log_debug_errno(r, "Failed to send units changed signal: %m");
+        }
+
+        set_clear(m->dbus_batched_units);
+        hashmap_clear_free_free(m->dbus_batched_removed);
+
+        (void) sd_event_source_set_enabled(m->dbus_batch_event_source, SD_EVENT_OFF);
+}
+
+static int on_units_changed_timeout(sd_event_source *s, usec_t usec, void *userdata) {
+        Manager *m = userdata;
+
+        assert(m);
+
+        bus_manager_flush_units_changed(m);
+        return 0;
+}
+
+static int units_changed_schedule(Manager *m) {
+        usec_t timeout;
+        int r, enabled;
+
+        assert(m);
+
+        /* The timer is started by the first change after a flush, and is not pushed out by later ones, so that
+         * a continuous stream of changes still results in one signal per window. */
+
+        if (m->dbus_batch_event_source) {
+                r = sd_event_source_get_enabled(m->dbus_batch_event_source, &enabled);
+                if (r < 0)
+                        return r;
+                if (enabled != SD_EVENT_OFF)
+                        return 0;
+        }
+
+        timeout = usec_add(now(CLOCK_MONOTONIC), UNITS_CHANGED_BATCH_USEC);
+
+        if (m->dbus_batch_event_source) {
+                r = sd_event_source_set_time(m->dbus_batch_event_source, timeout);
+                if (r < 0)
+                        return r;
+
+                return sd_event_source_set_enabled(m->dbus_batch_event_source, SD_EVENT_ONESHOT);
+        }
+
+        r = sd_event_add_time(
+                        m->event,
+                        &m->dbus_batch_event_source,
+                        CLOCK_MONOTONIC, timeout, UNITS_CHANGED_BATCH_ACCURACY_USEC,
+                        on_units_changed_timeout, m);
+        if (r < 0)
+                return r;
+
+        (void) sd_event_source_set_description(m->dbus_batch_event_source, "manager-units-changed");
+
+        return 0;
+}
+
+void bus_manager_queue_unit_changed(Manager *m, Unit *u) {
+        char *id;
+        int r;
+
+        assert(m);
+        assert(u);
+
+        if (sd_bus_track_count(m->subscribed_batched) <= 0)
+                return;
+
+        /* A unit that went away and came back within the same window (which is what happens to all units during
+         * a reload) is just reported as changed. */
+        free(hashmap_remove2(m->dbus_batched_removed, u->id, (void**) &id));
+        free(id);
+
+        r = set_ensure_allocated(&m->dbus_batched_units, NULL);
+        if (r < 0)
+                goto fail;
+
+        r = set_put(m->dbus_batched_units, u);
+        if (r < 0)
+                goto fail;
+
+        r = units_changed_schedule(m);
+        if (r < 0)
+                goto fail;
+
+        return;
+
+fail:
+        log_debug_errno(r, "Failed to queue units changed signal, sending it right away: %m");
+        bus_manager_flush_units_changed(m);
+}
+
+void bus_manager_queue_unit_removed(Manager *m, Unit *u) {
+        _cleanup_free_ char *id = NULL, *p = NULL;
+        int r;
+
+        assert(m);
+        assert(u);
+
+        (void) set_remove(m->dbus_batched_units, u);
+
+        if (sd_bus_track_count(m->subscribed_batched) <= 0)
+                return;
+
+        id = strdup(u->id);
+        p = unit_dbus_path(u);
+        if (!id || !p) {
+                r = -ENOMEM;
+                goto fail;
+        }
+
+        r = hashmap_ensure_allocated(&m->dbus_batched_removed, &string_hash_ops);
+        if (r < 0)
+                goto fail;
+
+        r = hashmap_put(m->dbus_batched_removed, id, p);
+        if (r < 0)
+                goto fail;
+        id = p = NULL;
+
+        r = units_changed_schedule(m);
+        if (r < 0)
+                goto fail;
+
+        return;
+
+fail:
+        log_debug_errno(r, "Failed to queue units changed signal, sending it right away: %m");
+        bus_manager_flush_units_changed(m);
+}
@@ -11,4 +11,8 @@ void bus_manager_send_finished(Manager *m, usec_t firmware_usec, usec_t loader_u
 void bus_manager_send_reloading(Manager *m, bool active);
 void bus_manager_send_change_signal(Manager *m);
 
+void bus_manager_queue_unit_changed(Manager *m, Unit *u);
+void bus_manager_queue_unit_removed(Manager *m, Unit *u);
+void bus_manager_flush_units_changed(Manager *m);
+
 int verify_run_space_and_log(const char *message);
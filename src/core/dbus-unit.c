@@ -8,6 +8,7 @@
 #include "cgroup-util.h"
 #include "condition.h"
 #include "dbus-job.h"
+#include "dbus-manager.h"
 #include "dbus-unit.h"
 #include "dbus-util.h"
 #include "dbus.h"
@@ -1255,6 +1256,8 @@ void bus_unit_send_change_signal(Unit *u) {
         if (r < 0)
                 log_unit_debug_errno(u, r, "Failed to send unit change signal for %s: %m", u->id);
 
+        bus_manager_queue_unit_changed(u->manager, u);
+
         u->sent_dbus_new_signal = true;
 }
 
@@ -1321,6 +1324,8 @@ void bus_unit_send_removed_signal(Unit *u) {
         r = bus_foreach_bus(u->manager, u->bus_track, send_removed_signal, u);
         if (r < 0)
                 log_unit_debug_errno(u, r, "Failed to send unit remove signal for %s: %m", u->id);
+
+        bus_manager_queue_unit_removed(u->manager, u);
 }
 
 int bus_unit_queue_job(
@@ -1064,6 +1064,8 @@ static void destroy_bus(Manager *m, sd_bus **bus) {
         /* Get rid of tracked clients on this bus */
         if (m->subscribed && sd_bus_track_get_bus(m->subscribed) == *bus)
                 m->subscribed = sd_bus_track_unref(m->subscribed);
+        if (m->subscribed_batched && sd_bus_track_get_bus(m->subscribed_batched) == *bus)
+                m->subscribed_batched = sd_bus_track_unref(m->subscribed_batched);
 
         HASHMAP_FOREACH(j, m->jobs, i)
                 if (j->bus_track && sd_bus_track_get_bus(j->bus_track) == *bus)
@@ -1116,8 +1118,10 @@ void bus_done(Manager *m) {
         bus_done_private(m);
 
         assert(!m->subscribed);
+        assert(!m->subscribed_batched);
 
         m->deserialized_subscribed = strv_free(m->deserialized_subscribed);
+        m->deserialized_subscribed_batched = strv_free(m->deserialized_subscribed_batched);
         bus_verify_polkit_async_registry_free(m->polkit_registry);
 }
 
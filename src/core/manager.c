@@ -55,6 +55,7 @@
 #include "memory-util.h"
 #include "missing.h"
 #include "mkdir.h"
+#include "nulstr-util.h"
 #include "parse-util.h"
 #include "path-lookup.h"
 #include "path-util.h"
@@ -65,6 +66,7 @@
 #include "rm-rf.h"
 #include "serialize.h"
 #include "signal-util.h"
+#include "siphash24.h"
 #include "socket-util.h"
 #include "special.h"
 #include "stat-util.h"
@@ -1323,6 +1325,8 @@ Manager* manager_free(Manager *m) {
 
         set_free(m->startup_units);
         set_free(m->failed_units);
+        set_free(m->dbus_batched_units);
+        hashmap_free_free_free(m->dbus_batched_removed);
 
         sd_event_source_unref(m->signal_event_source);
         sd_event_source_unref(m->sigchld_event_source);
@@ -1334,6 +1338,7 @@ Manager* manager_free(Manager *m) {
         sd_event_source_unref(m->run_queue_event_source);
         sd_event_source_unref(m->user_lookup_event_source);
         sd_event_source_unref(m->sync_bus_names_event_source);
+        sd_event_source_unref(m->dbus_batch_event_source);
 
         safe_close(m->signal_fd);
         safe_close(m->notify_fd);
@@ -1355,6 +1360,7 @@ Manager* manager_free(Manager *m) {
 
         hashmap_free(m->cgroup_unit);
         set_free_free(m->unit_path_cache);
+        hashmap_free(m->unit_path_cache_dirs);
 
         free(m->switch_root);
         free(m->switch_root_init);
@@ -1452,7 +1458,112 @@ static void manager_catchup(Manager *m) {
         }
 }
 
+typedef struct UnitPathCacheDir {
+        struct timespec mtime;
+        bool valid;
+        char **paths;
+} UnitPathCacheDir;
+
+static UnitPathCacheDir* unit_path_cache_dir_free(UnitPathCacheDir *c) {
+        if (!c)
+                return NULL;
+
+        strv_free(c->paths);
+        return mfree(c);
+}
+
+DEFINE_PRIVATE_HASH_OPS_FULL(unit_path_cache_dir_hash_ops, char, path_hash_func, path_compare_func, free,
+                             UnitPathCacheDir, unit_path_cache_dir_free);
+
+static int manager_enumerate_unit_path_dir(Manager *m, const char *path, UnitPathCacheDir **ret) {
+        _cleanup_closedir_ DIR *d = NULL;
+        _cleanup_strv_free_ char **paths = NULL;
+        size_t n = 0, allocated = 0;
+        UnitPathCacheDir *c;
+        struct dirent *de;
+        struct stat st;
+        usec_t started;
+        int r;
+
+        assert(m);
+        assert(path);
+        assert(ret);
+
+        /* Returns the listing of the directory 'path', from the cache if the directory didn't change since it
+         * was last enumerated. Returns 0 if the directory doesn't exist. */
+
+        started = now(CLOCK_REALTIME);
+
+        if (stat(path, &st) < 0) {
+                if (errno != ENOENT)
+                        log_warning_errno(errno, "Failed to stat directory %s, ignoring: %m", path);
+                return 0;
+        }
+
+        c = hashmap_get(m->unit_path_cache_dirs, path);
+        if (c && c->valid && timespec_load_nsec(&c->mtime) == timespec_load_nsec(&st.st_mtim)) {
+                *ret = c;
+                return 1;
+        }
+
+        d = opendir(path);
+        if (!d) {
+                if (errno != ENOENT)
+                        log_warning_errno(errno, "Failed to open directory %s, ignoring: %m", path);
+                return 0;
+        }
+
+        FOREACH_DIRENT(de, d, return -errno) {
+                char *p;
+
+                p = strjoin(streq(path, "/") ? "" : path, "/", de->d_name);
+                if (!p)
+                        return -ENOMEM;
+
+                if (!GREEDY_REALLOC(paths, allocated, n + 2)) {
+                        free(p);
+                        return -ENOMEM;
+                }
+
+                paths[n++] = p;
+                paths[n] = NULL;
+        }
+
+        if (!c) {
+                _cleanup_free_ char *key = NULL;
+
+                r = hashmap_ensure_allocated(&m->unit_path_cache_dirs, &unit_path_cache_dir_hash_ops);
+                if (r < 0)
+                        return r;
+
+                key = strdup(path);
+                if (!key)
+                        return -ENOMEM;
+
+                c = new0(UnitPathCacheDir, 1);
+                if (!c)
+                        return -ENOMEM;
+
+                r = hashmap_put(m->unit_path_cache_dirs, key, c);
+                if (r < 0) {
+                        free(c);
+                        return r;
+                }
+                key = NULL;
+        }
+
+        strv_free_and_replace(c->paths, paths);
+        c->mtime = st.st_mtim;
+        c->valid = timespec_load(&st.st_mtim) + UNIT_FILES_SETTLE_USEC <= started;
+
+        *ret = c;
+        return 1;
+}
+
 static void manager_build_unit_path_cache(Manager *m) {
+        UnitPathCacheDir *c;
+        const char *path;
+        Iterator j;
         char **i;
         int r;
 
@@ -1467,39 +1578,220 @@ static void manager_build_unit_path_cache(Manager *m) {
         }
 
         /* This simply builds a list of files we know exist, so that
-         * we don't always have to go to disk */
+         * we don't always have to go to disk. On reload most of the
+         * directories are unchanged, for those we reuse the listing
+         * from last time. */
 
         STRV_FOREACH(i, m->lookup_paths.search_path) {
+                r = manager_enumerate_unit_path_dir(m, *i, &c);
+                if (r < 0)
+                        goto fail;
+                if (r == 0)
+                        continue;
+
+                r = set_put_strdupv(m->unit_path_cache, c->paths);
+                if (r < 0)
+                        goto fail;
+        }
+
+        /* Forget about directories that are not in the search path anymore */
+        HASHMAP_FOREACH_KEY(c, path, m->unit_path_cache_dirs, j)
+                if (!strv_contains(m->lookup_paths.search_path, path)) {
+                        char *key;
+
+                        assert_se(hashmap_remove2(m->unit_path_cache_dirs, path, (void**) &key) == c);
+                        unit_path_cache_dir_free(c);
+                        free(key);
+                }
+
+        return;
+
+fail:
+        log_warning_errno(r, "Failed to build unit path cache, proceeding without: %m");
+        m->unit_path_cache = set_free_free(m->unit_path_cache);
+        m->unit_path_cache_dirs = hashmap_free(m->unit_path_cache_dirs);
+}
+
+static void fingerprint_stat(struct siphash *state, const struct stat *st, usec_t *newest) {
+        nsec_t mtime, ctime;
+
+        assert(state);
+        assert(st);
+        assert(newest);
+
+        /* The ctime is included since package managers like to preserve mtimes of the files they install */
+        mtime = timespec_load_nsec(&st->st_mtim);
+        ctime = timespec_load_nsec(&st->st_ctim);
+
+        siphash24_compress(&st->st_dev, sizeof(st->st_dev), state);
+        siphash24_compress(&st->st_ino, sizeof(st->st_ino), state);
+        siphash24_compress(&st->st_size, sizeof(st->st_size), state);
+        siphash24_compress(&mtime, sizeof(mtime), state);
+        siphash24_compress(&ctime, sizeof(ctime), state);
+
+        *newest = MAX3(*newest, timespec_load(&st->st_mtim), timespec_load(&st->st_ctim));
+}
+
+static int fingerprint_path(struct siphash *state, const char *path, bool by_content, unsigned depth, usec_t *newest) {
+        struct stat st;
+        int r;
+
+        assert(state);
+        assert(path);
+        assert(newest);
+
+        /* Hashes the file or directory 'path', and if it is a directory and depth > 0, its contents. Generator
+         * output is recreated on every run, hence it is hashed by its contents rather than its inode data. */
+
+        if (lstat(path, &st) < 0) {
+                if (errno != ENOENT)
+                        return -errno;
+
+                siphash24_compress_byte(0, state);
+                return 0;
+        }
+
+        if (S_ISLNK(st.st_mode)) {
+                _cleanup_free_ char *target = NULL;
+
+                r = readlink_malloc(path, &target);
+                if (r < 0)
+                        return r;
+
+                siphash24_compress(target, strlen(target) + 1, state);
+
+                if (stat(path, &st) < 0) {
+                        if (errno != ENOENT)
+                                return -errno;
+
+                        /* Dangling symlink */
+                        siphash24_compress_byte(0, state);
+                        return 0;
+                }
+        }
+
+        siphash24_compress(&st.st_mode, sizeof(st.st_mode), state);
+
+        if (!by_content)
+                fingerprint_stat(state, &st, newest);
+
+        if (S_ISDIR(st.st_mode) && depth > 0) {
+                _cleanup_strv_free_ char **names = NULL;
                 _cleanup_closedir_ DIR *d = NULL;
                 struct dirent *de;
+                char **i;
 
-                d = opendir(*i);
-                if (!d) {
-                        if (errno != ENOENT)
-                                log_warning_errno(errno, "Failed to open directory %s, ignoring: %m", *i);
-                        continue;
+                d = opendir(path);
+                if (!d)
+                        return -errno;
+
+                FOREACH_DIRENT(de, d, return -errno) {
+                        r = strv_extend(&names, de->d_name);
+                        if (r < 0)
+                                return r;
                 }
 
-                FOREACH_DIRENT(de, d, r = -errno; goto fail) {
-                        char *p;
+                /* The order of entries differs between directories with the same contents */
+                strv_sort(names);
 
-                        p = strjoin(streq(*i, "/") ? "" : *i, "/", de->d_name);
-                        if (!p) {
-                                r = -ENOMEM;
-                                goto fail;
-                        }
+                STRV_FOREACH(i, names) {
+                        _cleanup_free_ char *p = NULL;
+
+                        siphash24_compress(*i, strlen(*i) + 1, state);
 
-                        r = set_consume(m->unit_path_cache, p);
+                        p = path_join(path, *i);
+                        if (!p)
+                                return -ENOMEM;
+
+                        r = fingerprint_path(state, p, by_content, depth - 1, newest);
                         if (r < 0)
-                                goto fail;
+                                return r;
                 }
+
+        } else if (S_ISREG(st.st_mode) && by_content) {
+                _cleanup_free_ char *contents = NULL;
+                size_t size;
+
+                r = read_full_file(path, &contents, &size);
+                if (r < 0)
+                        return r;
+
+                siphash24_compress(&size, sizeof(size), state);
+                siphash24_compress(contents, size, state);
         }
 
-        return;
+        return 0;
+}
 
-fail:
-        log_warning_errno(r, "Failed to build unit path cache, proceeding without: %m");
-        m->unit_path_cache = set_free_free(m->unit_path_cache);
+int manager_unit_files_fingerprint(Manager *m, uint64_t *ret, bool *ret_trusted) {
+        static const sd_id128_t key = SD_ID128_MAKE(4e,0c,5d,f3,a1,7b,46,2e,93,18,d6,0f,2c,a5,e9,71);
+        const char *conf, *conf_dirs_nulstr, *p;
+        struct siphash state;
+        usec_t started, newest = 0;
+        char **i;
+        int r;
+
+        assert(m);
+        assert(ret);
+        assert(ret_trusted);
+
+        /* Computes a fingerprint of everything that goes into loading units: the unit search path directories
+         * with the unit files, drop-ins and .wants/.requires symlinks in them (including generator output), and the
+         * manager configuration, which provides defaults for units. */
+
+        started = now(CLOCK_REALTIME);
+        siphash24_init(&state, key.bytes);
+
+        STRV_FOREACH(i, m->lookup_paths.search_path) {
+                bool generated;
+
+                /* Transient units are only written by us, and their files always match the units we have in
+                 * memory. Let's not consider this directory, so that the frequent creation of scope units doesn't
+                 * make us reload needlessly. */
+                if (path_equal_ptr(*i, m->lookup_paths.transient))
+                        continue;
+
+                generated = path_equal_ptr(*i, m->lookup_paths.generator) ||
+                            path_equal_ptr(*i, m->lookup_paths.generator_early) ||
+                            path_equal_ptr(*i, m->lookup_paths.generator_late);
+
+                siphash24_compress(*i, strlen(*i) + 1, &state);
+
+                r = fingerprint_path(&state, *i, generated, 2, &newest);
+                if (r < 0)
+                        return r;
+        }
+
+        /* Keep this in sync with parse_config_file() in main.c */
+        conf = MANAGER_IS_SYSTEM(m) ? PKGSYSCONFDIR "/system.conf" : PKGSYSCONFDIR "/user.conf";
+        conf_dirs_nulstr = MANAGER_IS_SYSTEM(m) ? CONF_PATHS_NULSTR("systemd/system.conf.d") : CONF_PATHS_NULSTR("systemd/user.conf.d");
+
+        r = fingerprint_path(&state, conf, false, 0, &newest);
+        if (r < 0)
+                return r;
+
+        NULSTR_FOREACH(p, conf_dirs_nulstr) {
+                r = fingerprint_path(&state, p, false, 1, &newest);
+                if (r < 0)
+                        return r;
+        }
+
+        *ret = siphash24_finalize(&state);
+        *ret_trusted = newest + UNIT_FILES_SETTLE_USEC <= started;
+        return 0;
+}
+
+void manager_update_unit_files_fingerprint(Manager *m) {
+        bool trusted;
+        int r;
+
+        assert(m);
+
+        r = manager_unit_files_fingerprint(m, &m->unit_files_fingerprint, &trusted);
+        if (r < 0)
+                log_debug_errno(r, "Failed to fingerprint unit files, ignoring: %m");
+
+        m->unit_files_fingerprint_valid = r >= 0 && trusted;
 }
 
 static void manager_distribute_fds(Manager *m, FDSet *fds) {
@@ -1715,6 +2007,11 @@ int manager_startup(Manager *m, FILE *serialization, FDSet *fds) {
                         log_warning_errno(r, "Failed to deserialized tracked clients, ignoring: %m");
                 m->deserialized_subscribed = strv_free(m->deserialized_subscribed);
 
+                r = bus_track_coldplug(m, &m->subscribed_batched, false, m->deserialized_subscribed_batched);
+                if (r < 0)
+                        log_warning_errno(r, "Failed to deserialized tracked batched clients, ignoring: %m");
+                m->deserialized_subscribed_batched = strv_free(m->deserialized_subscribed_batched);
+
                 /* Third, fire things up! */
                 manager_coldplug(m);
 
@@ -3114,6 +3411,14 @@ int manager_open_serialization(Manager *m, FILE **_f) {
 
 static bool manager_timestamp_shall_serialize(ManagerTimestamp t) {
 
+        /* The reload timestamps are taken while the serialization is already written, deserializing them would
+         * overwrite the fresh values with the ones from the previous reload. */
+        if (IN_SET(t,
+                   MANAGER_TIMESTAMP_RELOAD_START, MANAGER_TIMESTAMP_RELOAD_FINISH,
+                   MANAGER_TIMESTAMP_RELOAD_GENERATORS_START, MANAGER_TIMESTAMP_RELOAD_GENERATORS_FINISH,
+                   MANAGER_TIMESTAMP_RELOAD_UNITS_LOAD_START, MANAGER_TIMESTAMP_RELOAD_UNITS_LOAD_FINISH))
+                return false;
+
         if (!in_initrd())
                 return true;
 
@@ -3208,6 +3513,7 @@ int manager_serialize(
         }
 
         bus_track_serialize(m->subscribed, f, "subscribed");
+        bus_track_serialize(m->subscribed_batched, f, "subscribed-batched");
 
         r = dynamic_user_serialize(m, f, fds);
         if (r < 0)
@@ -3475,6 +3781,11 @@ int manager_deserialize(Manager *m, FILE *f, FDSet *fds) {
                         if (strv_extend(&m->deserialized_subscribed, val) < 0)
                                 return -ENOMEM;
 
+                } else if ((val = startswith(l, "subscribed-batched="))) {
+
+                        if (strv_extend(&m->deserialized_subscribed_batched, val) < 0)
+                                return -ENOMEM;
+
                 } else {
                         ManagerTimestamp q;
 
@@ -3498,14 +3809,86 @@ int manager_deserialize(Manager *m, FILE *f, FDSet *fds) {
         return manager_deserialize_units(m, f, fds);
 }
 
+static void manager_reload_generators(Manager *m) {
+        int r;
+
+        assert(m);
+
+        lookup_paths_flush_generator(&m->lookup_paths);
+        lookup_paths_free(&m->lookup_paths);
+
+        r = lookup_paths_init(&m->lookup_paths, m->unit_file_scope, 0, NULL);
+        if (r < 0)
+                log_warning_errno(r, "Failed to initialize path lookup table, ignoring: %m");
+
+        dual_timestamp_get(m->timestamps + MANAGER_TIMESTAMP_RELOAD_GENERATORS_START);
+        (void) manager_run_environment_generators(m);
+        (void) manager_run_generators(m);
+        dual_timestamp_get(m->timestamps + MANAGER_TIMESTAMP_RELOAD_GENERATORS_FINISH);
+
+        r = lookup_paths_reduce(&m->lookup_paths);
+        if (r < 0)
+                log_warning_errno(r, "Failed ot reduce unit file paths, ignoring: %m");
+}
+
+bool manager_reload_needed(Manager *m) {
+        uint64_t fingerprint;
+        bool trusted;
+        int r;
+
+        assert(m);
+
+        if (!m->unit_files_fingerprint_valid)
+                return true;
+
+        r = manager_unit_files_fingerprint(m, &fingerprint, &trusted);
+        if (r < 0) {
+                log_debug_errno(r, "Failed to fingerprint unit files, reloading: %m");
+                return true;
+        }
+
+        return fingerprint != m->unit_files_fingerprint;
+}
+
 int manager_reload(Manager *m) {
         _cleanup_(manager_reloading_stopp) Manager *reloading = NULL;
         _cleanup_fdset_free_ FDSet *fds = NULL;
         _cleanup_fclose_ FILE *f = NULL;
+        bool regenerated = false;
         int r;
 
         assert(m);
 
+        if (m->reload_if_changed) {
+                m->reload_if_changed = false;
+
+                /* The generators need to run in any case, as their output depends on more than just files we
+                 * could check. Then, if their output and all unit files and drop-ins are unchanged since the
+                 * last time we loaded units, reloading would load the very same units again, so let's skip it.
+                 * Fingerprints are only recorded once somebody asks for this, hence the first call always
+                 * reloads. */
+                m->unit_files_fingerprint_wanted = true;
+
+                /* The reload starts here already, with the generators running before the serialization. If it
+                 * is skipped, the units load phase is recorded as empty at its end. */
+                dual_timestamp_get(m->timestamps + MANAGER_TIMESTAMP_RELOAD_START);
+                manager_reload_generators(m);
+                regenerated = true;
+
+                if (!manager_reload_needed(m)) {
+                        log_info("Unit files unchanged, skipping reload.");
+
+                        manager_build_unit_path_cache(m);
+
+                        dual_timestamp_get(m->timestamps + MANAGER_TIMESTAMP_RELOAD_FINISH);
+                        m->timestamps[MANAGER_TIMESTAMP_RELOAD_UNITS_LOAD_START] = m->timestamps[MANAGER_TIMESTAMP_RELOAD_FINISH];
+                        m->timestamps[MANAGER_TIMESTAMP_RELOAD_UNITS_LOAD_FINISH] = m->timestamps[MANAGER_TIMESTAMP_RELOAD_FINISH];
+
+                        m->objective = MANAGER_OK;
+                        return 0;
+                }
+        }
+
         r = manager_open_serialization(m, &f);
         if (r < 0)
                 return log_error_errno(r, "Failed to create serialization file: %m");
@@ -3517,6 +3900,9 @@ int manager_reload(Manager *m) {
         /* We are officially in reload mode from here on. */
         reloading = manager_reloading_start(m);
 
+        if (!regenerated)
+                dual_timestamp_get(m->timestamps + MANAGER_TIMESTAMP_RELOAD_START);
+
         r = manager_serialize(m, f, fds, false);
         if (r < 0)
                 return r;
@@ -3534,34 +3920,28 @@ int manager_reload(Manager *m) {
          * it.*/
 
         manager_clear_jobs_and_units(m);
-        lookup_paths_flush_generator(&m->lookup_paths);
-        lookup_paths_free(&m->lookup_paths);
         exec_runtime_vacuum(m);
         dynamic_user_vacuum(m, false);
         m->uid_refs = hashmap_free(m->uid_refs);
         m->gid_refs = hashmap_free(m->gid_refs);
 
-        r = lookup_paths_init(&m->lookup_paths, m->unit_file_scope, 0, NULL);
-        if (r < 0)
-                log_warning_errno(r, "Failed to initialize path lookup table, ignoring: %m");
-
-        (void) manager_run_environment_generators(m);
-        (void) manager_run_generators(m);
-
-        r = lookup_paths_reduce(&m->lookup_paths);
-        if (r < 0)
-                log_warning_errno(r, "Failed ot reduce unit file paths, ignoring: %m");
+        if (!regenerated)
+                manager_reload_generators(m);
 
+        if (m->unit_files_fingerprint_wanted)
+                manager_update_unit_files_fingerprint(m);
         manager_build_unit_path_cache(m);
 
         /* First, enumerate what we can from kernel and suchlike */
+        dual_timestamp_get(m->timestamps + MANAGER_TIMESTAMP_RELOAD_UNITS_LOAD_START);
         manager_enumerate_perpetual(m);
         manager_enumerate(m);
 
-        /* Second, deserialize our stored data */
+        /* Second, deserialize our stored data. This loads all units that were loaded before the reload. */
         r = manager_deserialize(m, f, fds);
         if (r < 0)
                 log_warning_errno(r, "Deserialization failed, proceeding anyway: %m");
+        dual_timestamp_get(m->timestamps + MANAGER_TIMESTAMP_RELOAD_UNITS_LOAD_FINISH);
 
         /* We don't need the serialization anymore */
         f = safe_fclose(f);
@@ -3588,6 +3968,8 @@ int manager_reload(Manager *m) {
 
         manager_ready(m);
 
+        dual_timestamp_get(m->timestamps + MANAGER_TIMESTAMP_RELOAD_FINISH);
+
         m->send_reloading_done = true;
         return 0;
 }
@@ -4712,6 +5094,12 @@ static const char *const manager_timestamp_table[_MANAGER_TIMESTAMP_MAX] = {
         [MANAGER_TIMESTAMP_INITRD_GENERATORS_FINISH] = "initrd-generators-finish",
         [MANAGER_TIMESTAMP_INITRD_UNITS_LOAD_START] = "initrd-units-load-start",
         [MANAGER_TIMESTAMP_INITRD_UNITS_LOAD_FINISH] = "initrd-units-load-finish",
+        [MANAGER_TIMESTAMP_RELOAD_START] = "reload-start",
+        [MANAGER_TIMESTAMP_RELOAD_GENERATORS_START] = "reload-generators-start",
+        [MANAGER_TIMESTAMP_RELOAD_GENERATORS_FINISH] = "reload-generators-finish",
+        [MANAGER_TIMESTAMP_RELOAD_UNITS_LOAD_START] = "reload-units-load-start",
+        [MANAGER_TIMESTAMP_RELOAD_UNITS_LOAD_FINISH] = "reload-units-load-finish",
+        [MANAGER_TIMESTAMP_RELOAD_FINISH] = "reload-finish",
 };
 
 DEFINE_STRING_TABLE_LOOKUP(manager_timestamp, ManagerTimestamp);
@@ -21,6 +21,11 @@ typedef struct Unit Unit;
 /* Enforce upper limit how many names we allow */
 #define MANAGER_MAX_NAMES 131072 /* 128K */
 
+/* Directory listings and unit file fingerprints are only trusted if the timestamps they are based on lie at least this
+ * far before the time they were taken. Otherwise a change made right afterwards might not have changed the timestamp,
+ * given the timestamp granularity of some file systems. */
+#define UNIT_FILES_SETTLE_USEC (2*USEC_PER_SEC)
+
 typedef struct Manager Manager;
 
 /* An externally visible state. We don't actually maintain this as state variable, but derive it from various fields
@@ -98,6 +103,14 @@ typedef enum ManagerTimestamp {
         MANAGER_TIMESTAMP_INITRD_GENERATORS_FINISH,
         MANAGER_TIMESTAMP_INITRD_UNITS_LOAD_START,
         MANAGER_TIMESTAMP_INITRD_UNITS_LOAD_FINISH,
+
+        /* The phases of the last daemon-reload */
+        MANAGER_TIMESTAMP_RELOAD_START,
+        MANAGER_TIMESTAMP_RELOAD_GENERATORS_START,
+        MANAGER_TIMESTAMP_RELOAD_GENERATORS_FINISH,
+        MANAGER_TIMESTAMP_RELOAD_UNITS_LOAD_START,
+        MANAGER_TIMESTAMP_RELOAD_UNITS_LOAD_FINISH,
+        MANAGER_TIMESTAMP_RELOAD_FINISH,
         _MANAGER_TIMESTAMP_MAX,
         _MANAGER_TIMESTAMP_INVALID = -1,
 } ManagerTimestamp;
@@ -156,6 +169,9 @@ struct Manager {
         /* Units that should be realized */
         LIST_HEAD(Unit, cgroup_realize_queue);
 
+        /* Slices whose members should be realized too */
+        LIST_HEAD(Unit, cgroup_siblings_queue);
+
         /* Units whose cgroup ran empty */
         LIST_HEAD(Unit, cgroup_empty_queue);
 
@@ -212,6 +228,10 @@ struct Manager {
         LookupPaths lookup_paths;
         Set *unit_path_cache;
 
+        /* The listing of each unit search path directory as of the last time unit_path_cache was built, together
+         * with the directory's mtime, so that unchanged directories needn't be enumerated again. */
+        Hashmap *unit_path_cache_dirs;
+
         char **transient_environment;  /* The environment, as determined from config files, kernel cmdline and environment generators */
         char **client_environment;     /* Environment variables created by clients through the bus API */
 
@@ -246,6 +266,14 @@ struct Manager {
         sd_bus_track *subscribed;
         char **deserialized_subscribed;
 
+        /* Clients that asked for unit changes to be batched into UnitsChanged signals, and the units changed or
+         * removed since the last one was sent out. */
+        sd_bus_track *subscribed_batched;
+        char **deserialized_subscribed_batched;
+        Set *dbus_batched_units;
+        Hashmap *dbus_batched_removed;
+        sd_event_source *dbus_batch_event_source;
+
         /* This is used during reloading: before the reload we queue
          * the reply message here, and afterwards we send it */
         sd_bus_message *pending_reload_message;
@@ -254,6 +282,14 @@ struct Manager {
 
         bool send_reloading_done;
 
+        /* Set by ReloadIfChanged(): skip the next reload if the fingerprint of all unit files, drop-ins,
+         * generator output and manager configuration didn't change since units were last loaded. The
+         * fingerprint is only recorded once ReloadIfChanged() has been used at least once. */
+        bool reload_if_changed;
+        bool unit_files_fingerprint_wanted;
+        bool unit_files_fingerprint_valid;
+        uint64_t unit_files_fingerprint;
+
         uint32_t current_job_id;
         uint32_t default_unit_job_id;
 
@@ -341,6 +377,10 @@ struct Manager {
         unsigned n_installed_jobs;
         unsigned n_failed_jobs;
 
+        /* cgroup attribute writes done, and those skipped since the value was written already */
+        unsigned n_cgroup_attribute_writes;
+        unsigned n_cgroup_attribute_writes_skipped;
+
         /* Jobs in progress watching */
         unsigned n_running_jobs;
         unsigned n_on_console;
@@ -457,6 +497,9 @@ int manager_open_serialization(Manager *m, FILE **_f);
 int manager_serialize(Manager *m, FILE *f, FDSet *fds, bool switching_root);
 int manager_deserialize(Manager *m, FILE *f, FDSet *fds);
 
+int manager_unit_files_fingerprint(Manager *m, uint64_t *ret, bool *ret_trusted);
+void manager_update_unit_files_fingerprint(Manager *m);
+bool manager_reload_needed(Manager *m);
 int manager_reload(Manager *m);
 
 void manager_reset_failed(Manager *m);
@@ -279,40 +279,39 @@ static int transaction_merge_jobs(Transaction *tr, sd_bus_error *e) {
 }
 
 static void transaction_drop_redundant(Transaction *tr) {
-        bool again;
+        Iterator i;
+        Job *j;
 
         /* Goes through the transaction and removes all jobs of the units whose jobs are all noops. If not
-         * all of a unit's jobs are redundant, they are kept. */
+         * all of a unit's jobs are redundant, they are kept.
+         *
+         * Whether a job is redundant only depends on its own unit, and deleting jobs without their
+         * dependencies only touches the hashmap entry of that unit, hence a single pass suffices. */
 
         assert(tr);
 
-        do {
-                Iterator i;
-                Job *j;
-
-                again = false;
-
-                HASHMAP_FOREACH(j, tr->jobs, i) {
-                        bool keep = false;
-                        Job *k;
-
-                        LIST_FOREACH(transaction, k, j)
-                                if (tr->anchor_job == k ||
-                                    !job_type_is_redundant(k->type, unit_active_state(k->unit)) ||
-                                    (k->unit->job && job_type_is_conflicting(k->type, k->unit->job->type))) {
-                                        keep = true;
-                                        break;
-                                }
+        HASHMAP_FOREACH(j, tr->jobs, i) {
+                Unit *u = j->unit;
+                bool keep = false;
+                Job *k;
 
-                        if (!keep) {
-                                log_trace("Found redundant job %s/%s, dropping from transaction.",
-                                          j->unit->id, job_type_to_string(j->type));
-                                transaction_delete_job(tr, j, false);
-                                again = true;
+                LIST_FOREACH(transaction, k, j)
+                        if (tr->anchor_job == k ||
+                            !job_type_is_redundant(k->type, unit_active_state(k->unit)) ||
+                            (k->unit->job && job_type_is_conflicting(k->type, k->unit->job->type))) {
+                                keep = true;
                                 break;
                         }
+
+                if (keep)
+                        continue;
+
+                while ((j = hashmap_get(tr->jobs, u))) {
+                        log_trace("Found redundant job %s/%s, dropping from transaction.",
+                                  j->unit->id, job_type_to_string(j->type));
+                        transaction_delete_job(tr, j, false);
                 }
-        } while (again);
+        }
 }
 
 _pure_ static bool unit_matters_to_anchor(Unit *u, Job *j) {
@@ -497,7 +496,11 @@ static void transaction_collect_garbage(Transaction *tr) {
 
         assert(tr);
 
-        /* Drop jobs that are not required by any other job */
+        /* Drop jobs that are not required by any other job.
+         *
+         * Since such a job isn't required by anything, deleting it never deletes other jobs with it, and
+         * only touches the hashmap entry of its own unit. Hence there's no need to start over after each
+         * deleted job, only another pass is needed for the jobs that were required by deleted jobs alone. */
 
         do {
                 Iterator i;
@@ -513,7 +516,7 @@ static void transaction_collect_garbage(Transaction *tr) {
                                 log_trace("Garbage collecting job %s/%s", j->unit->id, job_type_to_string(j->type));
                                 transaction_delete_job(tr, j, true);
                                 again = true;
-                                break;
+                                continue;
                         }
 
                         log_trace("Keeping job %s/%s because of %s/%s",
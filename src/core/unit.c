@@ -433,6 +433,7 @@ void unit_add_to_dbus_queue(Unit *u) {
 
         /* Shortcut things if nobody cares */
         if (sd_bus_track_count(u->manager->subscribed) <= 0 &&
+            sd_bus_track_count(u->manager->subscribed_batched) <= 0 &&
             sd_bus_track_count(u->bus_track) <= 0 &&
             set_isempty(u->manager->private_buses)) {
                 u->sent_dbus_new_signal = true;
@@ -648,12 +649,17 @@ void unit_free(Unit *u) {
         if (u->in_dbus_queue)
                 LIST_REMOVE(dbus_queue, u->manager->dbus_unit_queue, u);
 
+        (void) set_remove(u->manager->dbus_batched_units, u);
+
         if (u->in_gc_queue)
                 LIST_REMOVE(gc_queue, u->manager->gc_unit_queue, u);
 
         if (u->in_cgroup_realize_queue)
                 LIST_REMOVE(cgroup_realize_queue, u->manager->cgroup_realize_queue, u);
 
+        if (u->in_cgroup_siblings_queue)
+                LIST_REMOVE(cgroup_siblings_queue, u->manager->cgroup_siblings_queue, u);
+
         if (u->in_cgroup_empty_queue)
                 LIST_REMOVE(cgroup_empty_queue, u->manager->cgroup_empty_queue, u);
 
@@ -5084,46 +5090,43 @@ void unit_remove_dependencies(Unit *u, UnitDependencyMask mask) {
                 return;
 
         for (d = 0; d < _UNIT_DEPENDENCY_MAX; d++) {
-                bool done;
-
-                do {
-                        UnitDependencyInfo di;
-                        Unit *other;
-                        Iterator i;
-
-                        done = true;
+                UnitDependencyInfo di;
+                Unit *other;
+                Iterator i;
 
-                        HASHMAP_FOREACH_KEY(di.data, other, u->dependencies[d], i) {
-                                UnitDependency q;
+                /* Note that we update or drop the entry we are currently looking at while iterating through the
+                 * hashmap, which the hashmap explicitly permits. The reverse dependencies we fix up below live in
+                 * the other unit's hashmaps, which are never the one we are iterating through, since units cannot
+                 * depend on themselves. Hence a single pass suffices, and removing many dependencies from a unit
+                 * with many dependencies (as happens for mount and device units whenever their mountinfo or udev
+                 * data changes) is linear rather than quadratic. */
 
-                                if ((di.origin_mask & ~mask) == di.origin_mask)
-                                        continue;
-                                di.origin_mask &= ~mask;
-                                unit_update_dependency_mask(u, d, other, di);
-
-                                /* We updated the dependency from our unit to the other unit now. But most dependencies
-                                 * imply a reverse dependency. Hence, let's delete that one too. For that we go through
-                                 * all dependency types on the other unit and delete all those which point to us and
-                                 * have the right mask set. */
+                HASHMAP_FOREACH_KEY(di.data, other, u->dependencies[d], i) {
+                        UnitDependency q;
 
-                                for (q = 0; q < _UNIT_DEPENDENCY_MAX; q++) {
-                                        UnitDependencyInfo dj;
+                        if ((di.origin_mask & ~mask) == di.origin_mask)
+                                continue;
+                        di.origin_mask &= ~mask;
+                        unit_update_dependency_mask(u, d, other, di);
 
-                                        dj.data = hashmap_get(other->dependencies[q], u);
-                                        if ((dj.destination_mask & ~mask) == dj.destination_mask)
-                                                continue;
-                                        dj.destination_mask &= ~mask;
+                        /* We updated the dependency from our unit to the other unit now. But most dependencies
+                         * imply a reverse dependency. Hence, let's delete that one too. For that we go through
+                         * all dependency types on the other unit and delete all those which point to us and
+                         * have the right mask set. */
 
-                                        unit_update_dependency_mask(other, q, u, dj);
-                                }
+                        for (q = 0; q < _UNIT_DEPENDENCY_MAX; q++) {
+                                UnitDependencyInfo dj;
 
-                                unit_add_to_gc_queue(other);
+                                dj.data = hashmap_get(other->dependencies[q], u);
+                                if ((dj.destination_mask & ~mask) == dj.destination_mask)
+                                        continue;
+                                dj.destination_mask &= ~mask;
 
-                                done = false;
-                                break;
+                                unit_update_dependency_mask(other, q, u, dj);
                         }
 
-                } while (!done);
+                        unit_add_to_gc_queue(other);
+                }
         }
 }
 
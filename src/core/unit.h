@@ -197,6 +197,9 @@ typedef struct Unit {
         /* CGroup realize members queue */
         LIST_FIELDS(Unit, cgroup_realize_queue);
 
+        /* Slices whose members shall be checked for cgroup realization */
+        LIST_FIELDS(Unit, cgroup_siblings_queue);
+
         /* cgroup empty queue */
         LIST_FIELDS(Unit, cgroup_empty_queue);
 
@@ -252,6 +255,7 @@ typedef struct Unit {
         CGroupMask cgroup_enabled_mask;            /* Which controllers are enabled (or more correctly: enabled for the children) for this unit's cgroup? (only relevant on cgroup v2) */
         CGroupMask cgroup_invalidated_mask;        /* A mask specifiying controllers which shall be considered invalidated, and require re-realization */
         CGroupMask cgroup_members_mask;            /* A cache for the controllers required by all children of this cgroup (only relevant for slice units) */
+        Hashmap *cgroup_attribute_cache;           /* The values we last successfully wrote to the cgroup attributes */
         int cgroup_inotify_wd;
 
         /* Device Controller BPF program */
@@ -319,6 +323,7 @@ typedef struct Unit {
         bool in_cleanup_queue:1;
         bool in_gc_queue:1;
         bool in_cgroup_realize_queue:1;
+        bool in_cgroup_siblings_queue:1;
         bool in_cgroup_empty_queue:1;
         bool in_target_deps_queue:1;
         bool in_stop_when_unneeded_queue:1;
@@ -10,9 +10,10 @@
 #include "dirent-util.h"
 #include "fd-util.h"
 #include "fs-util.h"
-#include "hashmap.h"
 #include "macro.h"
 #include "memory-util.h"
+#include "prioq.h"
+#include "sort-util.h"
 #include "string-util.h"
 #include "time-util.h"
 #include "user-util.h"
@@ -22,27 +23,50 @@
 #define DEFAULT_KEEP_FREE_UPPER (uint64_t) (4ULL*1024ULL*1024ULL*1024ULL) /* 4 GiB */
 #define DEFAULT_KEEP_FREE (uint64_t) (1024ULL*1024ULL)                    /* 1 MB */
 
+struct vacuum_file {
+        char *name;
+        uid_t uid;
+        usec_t mtime;
+        uint64_t size;
+};
+
 struct vacuum_candidate {
-        unsigned n_files;
-        char *oldest_file;
-        usec_t oldest_mtime;
+        struct vacuum_file *files; /* The remaining files of this user, oldest first */
+        size_t n_files;
+        unsigned prioq_idx;
 };
 
-static void vacuum_candidate_free(struct vacuum_candidate *c) {
-        if (!c)
-                return;
+static void vacuum_files_free(struct vacuum_file *files, size_t n) {
+        size_t i;
+
+        for (i = 0; i < n; i++)
+                free(files[i].name);
 
-        free(c->oldest_file);
-        free(c);
+        free(files);
 }
 
-DEFINE_TRIVIAL_CLEANUP_FUNC(struct vacuum_candidate*, vacuum_candidate_free);
+static int vacuum_file_compare(const struct vacuum_file *a, const struct vacuum_file *b) {
+        int r;
+
+        r = CMP(a->uid, b->uid);
+        if (r != 0)
+                return r;
 
-static void vacuum_candidate_hashmap_free(Hashmap *h) {
-        hashmap_free_with_destructor(h, vacuum_candidate_free);
+        return CMP(a->mtime, b->mtime);
 }
 
-DEFINE_TRIVIAL_CLEANUP_FUNC(Hashmap*, vacuum_candidate_hashmap_free);
+static int vacuum_candidate_compare(const void *a, const void *b) {
+        const struct vacuum_candidate *x = a, *y = b;
+        int r;
+
+        /* The user with the most coredumps comes first, and among those the one with the oldest one */
+
+        r = CMP(y->n_files, x->n_files);
+        if (r != 0)
+                return r;
+
+        return CMP(x->files[0].mtime, y->files[0].mtime);
+}
 
 static int uid_from_file_name(const char *filename, uid_t *uid) {
         const char *p, *e, *u;
@@ -113,136 +137,193 @@ static bool vacuum_necessary(int fd, uint64_t sum, uint64_t keep_free, uint64_t
         return false;
 }
 
-int coredump_vacuum(int exclude_fd, uint64_t keep_free, uint64_t max_use) {
-        _cleanup_closedir_ DIR *d = NULL;
-        struct stat exclude_st;
+static int collect_files(
+                DIR *d,
+                const struct stat *exclude_st,
+                struct vacuum_file **ret,
+                size_t *ret_n,
+                uint64_t *ret_sum) {
+
+        struct vacuum_file *files = NULL;
+        size_t n = 0, n_allocated = 0;
+        uint64_t sum = 0;
+        struct dirent *de;
         int r;
 
-        if (keep_free == 0 && max_use == 0)
-                return 0;
+        assert(d);
+        assert(ret);
+        assert(ret_n);
+        assert(ret_sum);
 
-        if (exclude_fd >= 0) {
-                if (fstat(exclude_fd, &exclude_st) < 0)
-                        return log_error_errno(errno, "Failed to fstat(): %m");
-        }
+        FOREACH_DIRENT(de, d, goto fail) {
+                struct stat st;
+                uid_t uid;
 
-        /* This algorithm will keep deleting the oldest file of the
-         * user with the most coredumps until we are back in the size
-         * limits. Note that vacuuming for journal files is different,
-         * because we rely on rate-limiting of the messages there,
-         * to avoid being flooded. */
+                r = uid_from_file_name(de->d_name, &uid);
+                if (r < 0)
+                        continue;
 
-        d = opendir("/var/lib/systemd/coredump");
-        if (!d) {
-                if (errno == ENOENT)
-                        return 0;
+                if (fstatat(dirfd(d), de->d_name, &st, AT_NO_AUTOMOUNT|AT_SYMLINK_NOFOLLOW) < 0) {
+                        if (errno == ENOENT)
+                                continue;
 
-                return log_error_errno(errno, "Can't open coredump directory: %m");
-        }
+                        log_warning_errno(errno, "Failed to stat coredump %s: %m", de->d_name);
+                        continue;
+                }
 
-        for (;;) {
-                _cleanup_(vacuum_candidate_hashmap_freep) Hashmap *h = NULL;
-                struct vacuum_candidate *worst = NULL;
-                struct dirent *de;
-                uint64_t sum = 0;
+                if (!S_ISREG(st.st_mode))
+                        continue;
 
-                rewinddir(d);
+                if (exclude_st &&
+                    exclude_st->st_dev == st.st_dev &&
+                    exclude_st->st_ino == st.st_ino)
+                        continue;
 
-                FOREACH_DIRENT(de, d, goto fail) {
-                        struct vacuum_candidate *c;
-                        struct stat st;
-                        uid_t uid;
-                        usec_t t;
+                if (!GREEDY_REALLOC(files, n_allocated, n + 1)) {
+                        r = log_oom();
+                        goto finish;
+                }
 
-                        r = uid_from_file_name(de->d_name, &uid);
-                        if (r < 0)
-                                continue;
+                files[n] = (struct vacuum_file) {
+                        .name = strdup(de->d_name),
+                        .uid = uid,
+                        .mtime = timespec_load(&st.st_mtim),
+                        .size = st.st_blocks * 512,
+                };
+                if (!files[n].name) {
+                        r = log_oom();
+                        goto finish;
+                }
 
-                        if (fstatat(dirfd(d), de->d_name, &st, AT_NO_AUTOMOUNT|AT_SYMLINK_NOFOLLOW) < 0) {
-                                if (errno == ENOENT)
-                                        continue;
+                sum += files[n++].size;
+        }
 
-                                log_warning_errno(errno, "Failed to stat /var/lib/systemd/coredump/%s: %m", de->d_name);
-                                continue;
-                        }
+        *ret = TAKE_PTR(files);
+        *ret_n = n;
+        *ret_sum = sum;
+        return 0;
 
-                        if (!S_ISREG(st.st_mode))
-                                continue;
+fail:
+        r = log_error_errno(errno, "Failed to read directory: %m");
+finish:
+        vacuum_files_free(files, n);
+        return r;
+}
 
-                        if (exclude_fd >= 0 &&
-                            exclude_st.st_dev == st.st_dev &&
-                            exclude_st.st_ino == st.st_ino)
-                                continue;
+static int vacuum_files(int dir_fd, struct vacuum_file *files, size_t n_files, uint64_t sum, uint64_t keep_free, uint64_t max_use) {
+        _cleanup_free_ struct vacuum_candidate *candidates = NULL;
+        _cleanup_(prioq_freep) Prioq *q = NULL;
+        struct vacuum_candidate *c;
+        size_t i, n_candidates = 0;
+        int r;
 
-                        r = hashmap_ensure_allocated(&h, NULL);
-                        if (r < 0)
-                                return log_oom();
+        assert(dir_fd >= 0);
+        assert(files || n_files == 0);
 
-                        t = timespec_load(&st.st_mtim);
+        if (n_files == 0)
+                return 0;
 
-                        c = hashmap_get(h, UID_TO_PTR(uid));
-                        if (c) {
+        /* Group the files by user, oldest first */
+        typesafe_qsort(files, n_files, vacuum_file_compare);
 
-                                if (t < c->oldest_mtime) {
-                                        char *n;
+        candidates = new(struct vacuum_candidate, n_files);
+        if (!candidates)
+                return log_oom();
 
-                                        n = strdup(de->d_name);
-                                        if (!n)
-                                                return log_oom();
+        q = prioq_new(vacuum_candidate_compare);
+        if (!q)
+                return log_oom();
 
-                                        free(c->oldest_file);
-                                        c->oldest_file = n;
-                                        c->oldest_mtime = t;
-                                }
+        for (i = 0; i < n_files; i++) {
+                if (n_candidates > 0 && candidates[n_candidates-1].files[0].uid == files[i].uid) {
+                        candidates[n_candidates-1].n_files++;
+                        continue;
+                }
 
-                        } else {
-                                _cleanup_(vacuum_candidate_freep) struct vacuum_candidate *n = NULL;
+                candidates[n_candidates++] = (struct vacuum_candidate) {
+                        .files = files + i,
+                        .n_files = 1,
+                        .prioq_idx = PRIOQ_IDX_NULL,
+                };
+        }
 
-                                n = new0(struct vacuum_candidate, 1);
-                                if (!n)
-                                        return log_oom();
+        for (i = 0; i < n_candidates; i++) {
+                r = prioq_put(q, candidates + i, &candidates[i].prioq_idx);
+                if (r < 0)
+                        return log_oom();
+        }
 
-                                n->oldest_file = strdup(de->d_name);
-                                if (!n->oldest_file)
-                                        return log_oom();
+        while ((c = prioq_peek(q))) {
+                struct vacuum_file *f = c->files;
 
-                                n->oldest_mtime = t;
+                r = vacuum_necessary(dir_fd, sum, keep_free, max_use);
+                if (r <= 0)
+                        return r;
 
-                                r = hashmap_put(h, UID_TO_PTR(uid), n);
-                                if (r < 0)
-                                        return log_oom();
+                r = unlinkat_deallocate(dir_fd, f->name, 0);
+                if (r < 0 && r != -ENOENT)
+                        return log_error_errno(r, "Failed to remove file %s: %m", f->name);
+                if (r >= 0)
+                        log_info("Removed old coredump %s.", f->name);
 
-                                c = TAKE_PTR(n);
-                        }
+                sum -= MIN(sum, f->size);
 
-                        c->n_files++;
+                c->files++;
+                c->n_files--;
 
-                        if (!worst ||
-                            worst->n_files < c->n_files ||
-                            (worst->n_files == c->n_files && c->oldest_mtime < worst->oldest_mtime))
-                                worst = c;
+                if (c->n_files > 0)
+                        prioq_reshuffle(q, c, &c->prioq_idx);
+                else
+                        prioq_remove(q, c, &c->prioq_idx);
+        }
 
-                        sum += st.st_blocks * 512;
-                }
+        return 0;
+}
 
-                if (!worst)
-                        break;
+int coredump_vacuum_directory(const char *directory, int exclude_fd, uint64_t keep_free, uint64_t max_use) {
+        _cleanup_closedir_ DIR *d = NULL;
+        struct vacuum_file *files = NULL;
+        struct stat exclude_st;
+        size_t n_files = 0;
+        uint64_t sum = 0;
+        int r;
 
-                r = vacuum_necessary(dirfd(d), sum, keep_free, max_use);
-                if (r <= 0)
-                        return r;
+        if (keep_free == 0 && max_use == 0)
+                return 0;
 
-                r = unlinkat_deallocate(dirfd(d), worst->oldest_file, 0);
-                if (r == -ENOENT)
-                        continue;
-                if (r < 0)
-                        return log_error_errno(r, "Failed to remove file %s: %m", worst->oldest_file);
+        if (exclude_fd >= 0) {
+                if (fstat(exclude_fd, &exclude_st) < 0)
+                        return log_error_errno(errno, "Failed to fstat(): %m");
+        }
 
-                log_info("Removed old coredump %s.", worst->oldest_file);
+        /* This algorithm will keep deleting the oldest file of the
+         * user with the most coredumps until we are back in the size
+         * limits. Note that vacuuming for journal files is different,
+         * because we rely on rate-limiting of the messages there,
+         * to avoid being flooded.
+         *
+         * The directory is enumerated only once, and the files are
+         * then ordered by user and age, so that each deletion only
+         * costs a priority queue update. */
+
+        d = opendir(directory);
+        if (!d) {
+                if (errno == ENOENT)
+                        return 0;
+
+                return log_error_errno(errno, "Can't open coredump directory: %m");
         }
 
-        return 0;
+        r = collect_files(d, exclude_fd >= 0 ? &exclude_st : NULL, &files, &n_files, &sum);
+        if (r < 0)
+                return r;
 
-fail:
-        return log_error_errno(errno, "Failed to read directory: %m");
+        r = vacuum_files(dirfd(d), files, n_files, sum, keep_free, max_use);
+        vacuum_files_free(files, n_files);
+
+        return r;
+}
+
+int coredump_vacuum(int exclude_fd, uint64_t keep_free, uint64_t max_use) {
+        return coredump_vacuum_directory("/var/lib/systemd/coredump", exclude_fd, keep_free, max_use);
 }
@@ -4,4 +4,5 @@
 #include <inttypes.h>
 #include <sys/types.h>
 
+int coredump_vacuum_directory(const char *directory, int exclude_fd, uint64_t keep_free, uint64_t max_use);
 int coredump_vacuum(int exclude_fd, uint64_t keep_free, uint64_t max_use);
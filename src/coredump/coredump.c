@@ -375,7 +375,10 @@ static int save_external_coredump(
         if (fd < 0)
                 return log_error_errno(fd, "Failed to create temporary file for coredump %s: %m", fn);
 
-        r = copy_bytes(input_fd, fd, max_size, 0);
+        /* Core files tend to contain lots of zero pages (untouched heap, stacks, anonymous mappings), turn
+         * those into holes rather than writing them out. This also makes reading the file back for
+         * compression and backtrace generation cheaper. */
+        r = copy_bytes(input_fd, fd, max_size, COPY_SPARSE);
         if (r < 0) {
                 log_error_errno(r, "Cannot store coredump of %s (%s): %m", context[CONTEXT_PID], context[CONTEXT_COMM]);
                 goto fail;
@@ -680,6 +680,8 @@ static int dump_list(int argc, char **argv, void *userdata) {
                 if (r < 0)
                         return log_error_errno(r, "Failed to seek to date: %m");
 
+                /* The journal is iterated in time order, hence once we passed the end of the time range
+                 * there's no point in looking at the remaining entries, like journalctl does it. */
                 for (;;) {
                         if (!arg_reverse)
                                 r = sd_journal_next(j);
@@ -699,7 +701,7 @@ static int dump_list(int argc, char **argv, void *userdata) {
                                 if (r < 0)
                                         return log_error_errno(r, "Failed to determine timestamp: %m");
                                 if (usec > arg_until)
-                                        continue;
+                                        break;
                         }
 
                         if (arg_since != USEC_INFINITY && arg_reverse) {
@@ -709,7 +711,7 @@ static int dump_list(int argc, char **argv, void *userdata) {
                                 if (r < 0)
                                         return log_error_errno(r, "Failed to determine timestamp: %m");
                                 if (usec < arg_since)
-                                        continue;
+                                        break;
                         }
 
                         r = print_entry(j, n_found++, verb_is_info);
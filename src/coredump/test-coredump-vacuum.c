@@ -1,10 +1,112 @@
 /* SPDX-License-Identifier: LGPL-2.1+ */
 
+#include <fcntl.h>
 #include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include "alloc-util.h"
 #include "coredump-vacuum.h"
+#include "dirent-util.h"
+#include "fd-util.h"
+#include "format-util.h"
+#include "fs-util.h"
+#include "io-util.h"
+#include "log.h"
+#include "memory-util.h"
+#include "path-util.h"
+#include "rm-rf.h"
+#include "stdio-util.h"
+#include "tests.h"
+#include "tmpfile-util.h"
+#include "user-util.h"
+
+static uint64_t create_core(const char *directory, uid_t uid, unsigned i, usec_t mtime) {
+        char name[STRLEN("core.test...") + DECIMAL_STR_MAX(uid_t) + DECIMAL_STR_MAX(unsigned) + 1];
+        _cleanup_free_ char *p = NULL, *buf = NULL;
+        _cleanup_close_ int fd = -1;
+        struct timespec ts[2];
+        struct stat st;
+
+        xsprintf(name, "core.test." UID_FMT ".%u", uid, i);
+        assert_se(p = path_join(directory, name));
+
+        assert_se(buf = malloc(page_size()));
+        memset(buf, 'x', page_size());
+
+        fd = open(p, O_WRONLY|O_CREAT|O_EXCL|O_CLOEXEC, 0600);
+        assert_se(fd >= 0);
+        assert_se(loop_write(fd, buf, page_size(), false) == 0);
+
+        timespec_store(&ts[0], mtime);
+        ts[1] = ts[0];
+        assert_se(futimens(fd, ts) >= 0);
+
+        assert_se(fstat(fd, &st) >= 0);
+        return st.st_blocks * 512;
+}
+
+static void test_vacuum_directory(void) {
+        _cleanup_(rm_rf_physical_and_freep) char *t = NULL;
+        bool slow = slow_tests_enabled();
+        unsigned i, n = slow ? 30000 : 100, n_left[3] = {}, oldest_left[3] = { UINT_MAX, UINT_MAX, UINT_MAX }, n_deleted;
+        char b[FORMAT_TIMESPAN_MAX];
+        _cleanup_closedir_ DIR *d = NULL;
+        uint64_t sum = 0, size = 0;
+        struct dirent *de;
+        usec_t ts;
+
+        log_info("/* %s (%s) */", __func__, slow ? "slow" : "fast");
+
+        assert_se(mkdtemp_malloc("/tmp/test-coredump-vacuum-XXXXXX", &t) >= 0);
+
+        /* UID 1000 has twice as many cores as UID 1001, and all of them are older. UID 1002 only has a few
+         * recent ones. Cores are numbered in the order they were created. */
+        for (i = 0; i < 2 * n; i++)
+                sum += size = create_core(t, 1000, i, (i + 1) * USEC_PER_SEC);
+        for (i = 0; i < n; i++)
+                sum += create_core(t, 1001, 2 * n + i, (2 * n + i + 1) * USEC_PER_SEC);
+        for (i = 0; i < 10; i++)
+                sum += create_core(t, 1002, 3 * n + i, (3 * n + i + 1) * USEC_PER_SEC);
+
+        if (size == 0 || size % page_size() != 0) {
+                log_info("Unexpected allocation size %" PRIu64 " of the cores, skipping.", size);
+                return;
+        }
+
+        /* Make room for 3n/2 cores: the first n are taken from UID 1000, which then has as many as UID 1001,
+         * and the rest is split evenly among the two. UID 1002 is not touched. */
+        n_deleted = 3 * n / 2;
+
+        ts = now(CLOCK_MONOTONIC);
+        assert_se(coredump_vacuum_directory(t, -1, 0, sum - n_deleted * size) >= 0);
+        log_info("Vacuuming %u cores took %s", 3 * n + 10, format_timespan(b, sizeof b, now(CLOCK_MONOTONIC) - ts, 0));
+
+        assert_se(d = opendir(t));
+        FOREACH_DIRENT(de, d, assert_not_reached("readdir() failed")) {
+                unsigned k;
+                uid_t uid;
+
+                assert_se(sscanf(de->d_name, "core.test." UID_FMT ".%u", &uid, &k) == 2);
+                assert_se(uid >= 1000 && uid <= 1002);
+                oldest_left[uid - 1000] = MIN(oldest_left[uid - 1000], k);
+                n_left[uid - 1000]++;
+        }
+
+        assert_se(n_left[0] == 2 * n - n - (n_deleted - n) / 2);
+        assert_se(n_left[1] == n - (n_deleted - n) / 2);
+        assert_se(n_left[2] == 10);
+
+        /* Only the oldest cores of each user are deleted */
+        assert_se(oldest_left[0] == 2 * n - n_left[0]);
+        assert_se(oldest_left[1] == 3 * n - n_left[1]);
+        assert_se(oldest_left[2] == 3 * n);
+}
 
 int main(int argc, char *argv[]) {
+        test_setup_logging(LOG_INFO);
+
+        test_vacuum_directory();
 
         if (coredump_vacuum(-1, (uint64_t) -1, 70 * 1024) < 0)
                 return EXIT_FAILURE;
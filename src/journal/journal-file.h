@@ -76,6 +76,12 @@ typedef struct JournalFile {
         LocationType location_type;
         uint64_t last_n_entries;
 
+        /* Caches whether the current set of matches can be satisfied by this file at all, see
+         * file_may_match() in sd-journal.c */
+        uint64_t match_cache_generation;
+        uint64_t match_cache_n_data;
+        bool match_cache_possible;
+
         char *path;
         struct stat last_stat;
         usec_t last_stat_usec;
@@ -80,6 +80,7 @@ struct sd_journal {
         uint64_t current_field;
 
         Match *level0, *level1, *level2;
+        uint64_t match_generation;
 
         pid_t original_pid;
 
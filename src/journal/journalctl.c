@@ -10,6 +10,7 @@
 #include <signal.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <stdio_ext.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/inotify.h>
@@ -72,6 +73,8 @@
 
 #define PROCESS_INOTIFY_INTERVAL 1024   /* Every 1,024 messages processed */
 
+#define BULK_OUTPUT_BUFFER_SIZE (128U*1024U)
+
 #if HAVE_PCRE2
 DEFINE_TRIVIAL_CLEANUP_FUNC(pcre2_match_data*, pcre2_match_data_free);
 DEFINE_TRIVIAL_CLEANUP_FUNC(pcre2_code*, pcre2_code_free);
@@ -2092,6 +2095,26 @@ static int wait_for_change(sd_journal *j, int poll_fd) {
         return 0;
 }
 
+static void setup_bulk_output(void) {
+        static char buffer[BULK_OUTPUT_BUFFER_SIZE];
+
+        /* When dumping the journal in one of the machine-readable formats we write many tiny fragments per
+         * entry (every escaped character of JSON output is a separate fputc()). Let's use a large output
+         * buffer to reduce the number of write() calls, and turn off stdio's implicit locking of stdout, as
+         * we are single-threaded anyway. This must be called before anything is written to stdout. */
+
+        if (arg_follow)
+                return;
+
+        if (!IN_SET(arg_output, OUTPUT_EXPORT, OUTPUT_JSON, OUTPUT_JSON_PRETTY, OUTPUT_JSON_SSE, OUTPUT_JSON_SEQ, OUTPUT_CAT))
+                return;
+
+        if (setvbuf(stdout, buffer, _IOFBF, sizeof(buffer)) != 0)
+                log_debug("Failed to enlarge stdout buffer, ignoring.");
+
+        (void) __fsetlocking(stdout, FSETLOCKING_BYCALLER);
+}
+
 int main(int argc, char *argv[]) {
         bool previous_boot_id_valid = false, first_line = true, ellipsized = false, need_seek = false;
         bool use_cursor = false, after_cursor = false;
@@ -2531,6 +2554,8 @@ int main(int argc, char *argv[]) {
         if (r == 0)
                 need_seek = true;
 
+        setup_bulk_output();
+
         if (!arg_follow)
                 (void) pager_open(arg_pager_flags);
 
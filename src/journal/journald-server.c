@@ -76,6 +76,9 @@
 
 #define DEFERRED_CLOSES_MAX (4096)
 
+/* How many datagrams to process per wakeup of a datagram socket, before giving the other event sources a chance */
+#define DATAGRAMS_PER_WAKEUP_MAX 16U
+
 static int determine_path_usage(Server *s, const char *path, uint64_t *ret_used, uint64_t *ret_free) {
         _cleanup_closedir_ DIR *d = NULL;
         struct dirent *de;
@@ -1212,8 +1215,7 @@ finish:
         return r;
 }
 
-int server_process_datagram(sd_event_source *es, int fd, uint32_t revents, void *userdata) {
-        Server *s = userdata;
+static int server_process_one_datagram(Server *s, int fd, bool first) {
         struct ucred *ucred = NULL;
         struct timeval *tv = NULL;
         struct cmsghdr *cmsg;
@@ -1221,7 +1223,7 @@ int server_process_datagram(sd_event_source *es, int fd, uint32_t revents, void
         size_t label_len = 0, m;
         struct iovec iovec;
         ssize_t n;
-        int *fds = NULL, v = 0;
+        int *fds = NULL, v = 0, r;
         size_t n_fds = 0;
 
         union {
@@ -1254,14 +1256,15 @@ int server_process_datagram(sd_event_source *es, int fd, uint32_t revents, void
         assert(s);
         assert(fd == s->native_fd || fd == s->syslog_fd || fd == s->audit_fd);
 
-        if (revents != EPOLLIN)
-                return log_error_errno(SYNTHETIC_ERRNO(EIO),
-                                       "Got invalid event from epoll for datagram fd: %" PRIx32,
-                                       revents);
-
         /* Try to get the right size, if we can. (Not all sockets support SIOCINQ, hence we just try, but don't rely on
          * it.) */
-        (void) ioctl(fd, SIOCINQ, &v);
+        r = ioctl(fd, SIOCINQ, &v);
+
+        /* If we already processed a datagram in this wakeup and nothing is queued anymore, don't bother with
+         * recvmsg() just to get EAGAIN. A datagram without payload that might be queued is picked up on the
+         * next wakeup. */
+        if (!first && r >= 0 && v == 0)
+                return 0;
 
         /* Fix it up, if it is too small. We use the same fixed value as auditd here. Awful! */
         m = PAGE_ALIGN(MAX3((size_t) v + 1,
@@ -1327,6 +1330,29 @@ int server_process_datagram(sd_event_source *es, int fd, uint32_t revents, void
         }
 
         close_many(fds, n_fds);
+        return 1;
+}
+
+int server_process_datagram(sd_event_source *es, int fd, uint32_t revents, void *userdata) {
+        Server *s = userdata;
+        unsigned i;
+        int r;
+
+        assert(s);
+
+        if (revents != EPOLLIN)
+                return log_error_errno(SYNTHETIC_ERRNO(EIO),
+                                       "Got invalid event from epoll for datagram fd: %" PRIx32,
+                                       revents);
+
+        /* Under load the socket usually has more than one datagram queued. Process a couple of them in one go
+         * rather than going through epoll_wait() again for each of them. */
+        for (i = 0; i < DATAGRAMS_PER_WAKEUP_MAX; i++) {
+                r = server_process_one_datagram(s, fd, i == 0);
+                if (r <= 0)
+                        return r;
+        }
+
         return 0;
 }
 
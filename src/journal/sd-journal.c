@@ -322,6 +322,7 @@ _public_ int sd_journal_add_match(sd_journal *j, const void *data, size_t size)
         if (!m->data)
                 goto fail;
 
+        j->match_generation++;
         detach_location(j);
 
         return 0;
@@ -430,6 +431,7 @@ _public_ void sd_journal_flush_matches(sd_journal *j) {
                 match_free(j->level0);
 
         j->level0 = j->level1 = j->level2 = NULL;
+        j->match_generation++;
 
         detach_location(j);
 }
@@ -735,6 +737,68 @@ static int next_with_matches(
                               direction, ret, offset);
 }
 
+static int match_possible(JournalFile *f, Match *m) {
+        Match *i;
+        int r;
+
+        assert(f);
+        assert(m);
+
+        /* Checks whether the match could be satisfied by any entry of the file, only taking into account
+         * which DATA objects exist in it. Returns > 0 if it might, 0 if it certainly can't. */
+
+        if (m->type == MATCH_DISCRETE)
+                return journal_file_find_data_object_with_hash(f, m->data, m->size, le64toh(m->le_hash), NULL, NULL);
+
+        LIST_FOREACH(matches, i, m->matches) {
+                r = match_possible(f, i);
+                if (r < 0)
+                        return r;
+
+                if (m->type == MATCH_OR_TERM && r > 0)
+                        return 1;
+                if (m->type == MATCH_AND_TERM && r == 0)
+                        return 0;
+        }
+
+        /* An empty term never matches, see next_for_match() */
+        return m->type == MATCH_AND_TERM && m->matches;
+}
+
+static int file_may_match(sd_journal *j, JournalFile *f) {
+        uint64_t n_data;
+        int r;
+
+        assert(j);
+        assert(f);
+
+        if (!j->level0)
+                return 1;
+
+        /* Old files don't tell us how many DATA objects they contain, hence we can't tell whether the
+         * result is still valid. Let's not bother with the cache for them. */
+        if (!JOURNAL_HEADER_CONTAINS(f->header, n_data))
+                return 1;
+
+        /* Every seek and every change of direction makes us look up the matches in each file again. For
+         * files that can't match at all (which is the common case when looking for a rare field value in a
+         * long list of archived files), remember that until either the matches change or new DATA objects
+         * are added to the file. */
+        n_data = le64toh(f->header->n_data);
+        if (f->match_cache_generation == j->match_generation && f->match_cache_n_data == n_data)
+                return f->match_cache_possible;
+
+        r = match_possible(f, j->level0);
+        if (r < 0)
+                return r;
+
+        f->match_cache_generation = j->match_generation;
+        f->match_cache_n_data = n_data;
+        f->match_cache_possible = r > 0;
+
+        return f->match_cache_possible;
+}
+
 static int next_beyond_location(sd_journal *j, JournalFile *f, direction_t direction) {
         Object *c;
         uint64_t cp, n_entries;
@@ -751,6 +815,10 @@ static int next_beyond_location(sd_journal *j, JournalFile *f, direction_t direc
             n_entries == f->last_n_entries)
                 return 0;
 
+        r = file_may_match(j, f);
+        if (r <= 0)
+                return r;
+
         f->last_n_entries = n_entries;
 
         if (f->last_direction == direction && f->current_offset > 0) {
@@ -3,10 +3,13 @@
 #include <fcntl.h>
 #include <unistd.h>
 
+#include "sd-journal.h"
+
 #include "chattr-util.h"
 #include "io-util.h"
 #include "journal-authenticate.h"
 #include "journal-file.h"
+#include "journal-internal.h"
 #include "journal-vacuum.h"
 #include "log.h"
 #include "rm-rf.h"
@@ -240,6 +243,73 @@ static void test_min_compress_size(void) {
 }
 #endif
 
+static void test_match_cache(void) {
+        sd_journal *j;
+        char t[] = "/var/tmp/journal-match-XXXXXX";
+        struct iovec iovec;
+        dual_timestamp ts;
+        JournalFile *f, *rf;
+        uint64_t generation;
+
+        test_setup_logging(LOG_DEBUG);
+
+        mkdtemp_chdir_chattr(t);
+
+        assert_se(journal_file_open(-1, "test.journal", O_RDWR|O_CREAT, 0666, true, (uint64_t) -1, false, NULL, NULL, NULL, NULL, &f) == 0);
+
+        assert_se(dual_timestamp_get(&ts));
+        iovec = IOVEC_MAKE_STRING("TEST=1");
+        assert_se(journal_file_append_entry(f, &ts, NULL, &iovec, 1, NULL, NULL, NULL) == 0);
+
+        assert_se(sd_journal_open_directory(&j, t, 0) >= 0);
+        assert_se(rf = ordered_hashmap_first(j->files));
+
+        /* A match no DATA object of the file satisfies: the file is skipped, and that is remembered */
+        assert_se(sd_journal_add_match(j, "TEST=2", 0) >= 0);
+        assert_se(sd_journal_next(j) == 0);
+        assert_se(rf->match_cache_generation == j->match_generation);
+        assert_se(!rf->match_cache_possible);
+
+        generation = j->match_generation;
+        assert_se(sd_journal_seek_head(j) >= 0);
+        assert_se(sd_journal_next(j) == 0);
+        assert_se(rf->match_cache_generation == generation);
+
+        /* Changing the matches invalidates the verdict */
+        sd_journal_flush_matches(j);
+        assert_se(j->match_generation != generation);
+        assert_se(sd_journal_add_match(j, "TEST=1", 0) >= 0);
+        assert_se(sd_journal_seek_head(j) >= 0);
+        assert_se(sd_journal_next(j) == 1);
+        assert_se(rf->match_cache_generation == j->match_generation);
+        assert_se(rf->match_cache_possible);
+
+        sd_journal_flush_matches(j);
+        assert_se(sd_journal_add_match(j, "TEST=3", 0) >= 0);
+        assert_se(sd_journal_seek_head(j) >= 0);
+        assert_se(sd_journal_next(j) == 0);
+        assert_se(!rf->match_cache_possible);
+
+        /* New DATA objects appended to the open file make us look again */
+        iovec = IOVEC_MAKE_STRING("TEST=3");
+        assert_se(journal_file_append_entry(f, &ts, NULL, &iovec, 1, NULL, NULL, NULL) == 0);
+
+        assert_se(sd_journal_seek_head(j) >= 0);
+        assert_se(sd_journal_next(j) == 1);
+        assert_se(rf->match_cache_possible);
+        assert_se(rf->match_cache_n_data == le64toh(rf->header->n_data));
+
+        sd_journal_close(j);
+        (void) journal_file_close(f);
+
+        if (arg_keep)
+                log_info("Not removing %s", t);
+        else
+                assert_se(rm_rf(t, REMOVE_ROOT|REMOVE_PHYSICAL) >= 0);
+
+        puts("------------------------------------------------------------");
+}
+
 int main(int argc, char *argv[]) {
         arg_keep = argc > 1;
 
@@ -251,6 +321,7 @@ int main(int argc, char *argv[]) {
 
         test_non_empty();
         test_empty();
+        test_match_cache();
 #if HAVE_XZ || HAVE_LZ4
         test_min_compress_size();
 #endif
@@ -98,6 +98,9 @@ struct node_vtable {
         const sd_bus_vtable *vtable;
         sd_bus_object_find_t find;
 
+        /* The introspection data of the vtable's members, formatted on first use */
+        char *introspection;
+
         LIST_FIELDS(struct node_vtable, vtables);
 };
 
@@ -215,6 +218,7 @@ struct sd_bus {
 
         void *rbuffer;
         size_t rbuffer_size;
+        size_t rbuffer_allocated;
 
         sd_bus_message **rqueue;
         size_t rqueue_size;
@@ -268,6 +272,7 @@ struct sd_bus {
 
         int *fds;
         size_t n_fds;
+        size_t fds_offset; /* Offset in rbuffer of the message fds belongs to */
 
         char *exec_path;
         char **exec_argv;
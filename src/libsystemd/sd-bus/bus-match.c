@@ -55,9 +55,27 @@ static bool BUS_MATCH_IS_COMPARE(enum bus_match_node_type t) {
 }
 
 static bool BUS_MATCH_CAN_HASH(enum bus_match_node_type t) {
-        return (t >= BUS_MATCH_MESSAGE_TYPE && t <= BUS_MATCH_PATH) ||
+        return (t >= BUS_MATCH_SENDER && t <= BUS_MATCH_PATH_NAMESPACE) ||
                 (t >= BUS_MATCH_ARG && t <= BUS_MATCH_ARG_LAST) ||
-                (t >= BUS_MATCH_ARG_HAS && t <= BUS_MATCH_ARG_HAS_LAST);
+                (t >= BUS_MATCH_ARG_NAMESPACE && t <= BUS_MATCH_ARG_HAS_LAST);
+}
+
+static bool BUS_MATCH_IS_NAMESPACE(enum bus_match_node_type t) {
+        return t == BUS_MATCH_PATH_NAMESPACE ||
+                (t >= BUS_MATCH_ARG_NAMESPACE && t <= BUS_MATCH_ARG_NAMESPACE_LAST);
+}
+
+static bool bus_match_value_hashed(enum bus_match_node_type parent_type, const char *value_str) {
+
+        if (!BUS_MATCH_CAN_HASH(parent_type))
+                return false;
+
+        /* Matches on well-known sender names also apply to messages from unique names, see
+         * value_node_test(), hence we keep them in the child list and only hash unique names. */
+        if (parent_type == BUS_MATCH_SENDER)
+                return value_str && value_str[0] == ':';
+
+        return true;
 }
 
 static void bus_match_node_free(struct bus_match_node *node) {
@@ -67,7 +85,7 @@ static void bus_match_node_free(struct bus_match_node *node) {
         assert(node->type != BUS_MATCH_ROOT);
         assert(node->type < _BUS_MATCH_NODE_TYPE_MAX);
 
-        if (node->parent->child) {
+        if (node->prev || node->parent->child == node) {
                 /* We are apparently linked into the parent's child
                  * list. Let's remove us from there. */
                 if (node->prev) {
@@ -88,7 +106,7 @@ static void bus_match_node_free(struct bus_match_node *node) {
 
                 if (node->parent->type == BUS_MATCH_MESSAGE_TYPE)
                         hashmap_remove(node->parent->compare.children, UINT_TO_PTR(node->value.u8));
-                else if (BUS_MATCH_CAN_HASH(node->parent->type) && node->value.str)
+                else if (node->value.str && bus_match_value_hashed(node->parent->type, node->value.str))
                         hashmap_remove(node->parent->compare.children, node->value.str);
 
                 free(node->value.str);
@@ -241,6 +259,65 @@ static bool value_node_same(
         }
 }
 
+static int bus_match_run_prefixes(
+                sd_bus *bus,
+                struct bus_match_node *node,
+                const char *value,
+                sd_bus_message *m) {
+
+        _cleanup_free_ char *p = NULL;
+        char separator;
+        size_t i;
+        int r;
+
+        assert(node);
+        assert(BUS_MATCH_IS_NAMESPACE(node->type));
+        assert(value);
+
+        /* Namespace matches apply to the value itself and to all its prefixes that end right before or
+         * right after a separator, see simple_pattern_check(). Look up each of those in the hash table,
+         * so that the cost depends on the number of labels in the value, not on the number of matches. */
+
+        separator = node->type == BUS_MATCH_PATH_NAMESPACE ? '/' : '.';
+
+        p = strdup(value);
+        if (!p)
+                return -ENOMEM;
+
+        for (i = 0;; i++) {
+                struct bus_match_node *found;
+                size_t k;
+
+                if (value[i] != 0 && value[i] != separator)
+                        continue;
+
+                /* The prefix ending right before the separator, the one ending right after it, and
+                 * finally the whole value. If the previous character is a separator too, the former was
+                 * already looked up as the prefix ending right after that one. */
+                for (k = i > 0 && value[i-1] == separator && value[i] != 0 ? i + 1 : i; k <= i + 1; k++) {
+                        if (k > i && (value[i] == 0 || value[k] == 0))
+                                break;
+
+                        p[k] = 0;
+                        found = hashmap_get(node->compare.children, p);
+                        p[k] = value[k];
+
+                        if (!found)
+                                continue;
+
+                        r = bus_match_run(bus, found, m);
+                        if (r != 0)
+                                return r;
+
+                        if (bus && bus->match_callbacks_modified)
+                                return 0;
+                }
+
+                if (value[i] == 0)
+                        return 0;
+        }
+}
+
 int bus_match_run(
                 sd_bus *bus,
                 struct bus_match_node *node,
@@ -373,7 +450,15 @@ int bus_match_run(
                 assert_not_reached("Unknown match type.");
         }
 
-        if (BUS_MATCH_CAN_HASH(node->type)) {
+        if (BUS_MATCH_IS_NAMESPACE(node->type)) {
+
+                if (test_str) {
+                        r = bus_match_run_prefixes(bus, node, test_str, m);
+                        if (r != 0)
+                                return r;
+                }
+
+        } else if (BUS_MATCH_CAN_HASH(node->type)) {
                 struct bus_match_node *found;
 
                 /* Lookup via hash table, nice! So let's jump directly. */
@@ -403,10 +488,16 @@ int bus_match_run(
                         if (r != 0)
                                 return r;
                 }
-        } else {
+        }
+
+        if (node->child) {
                 struct bus_match_node *c;
 
-                /* No hash table, so let's iterate manually... */
+                /* No hash table (or not for all values, as for well-known sender names), so let's
+                 * iterate manually... */
+
+                if (bus && bus->match_callbacks_modified)
+                        return 0;
 
                 for (c = node->child; c; c = c->next) {
                         if (!value_node_test(c, node->type, test_u8, test_str, test_strv, m))
@@ -452,7 +543,7 @@ static int bus_match_add_compare_value(
 
                 if (t == BUS_MATCH_MESSAGE_TYPE)
                         n = hashmap_get(c->compare.children, UINT_TO_PTR(value_u8));
-                else if (BUS_MATCH_CAN_HASH(t))
+                else if (bus_match_value_hashed(t, value_str))
                         n = hashmap_get(c->compare.children, value_str);
                 else {
                         for (n = c->child; n && !value_node_same(n, t, value_u8, value_str); n = n->next)
@@ -512,7 +603,7 @@ static int bus_match_add_compare_value(
         }
 
         n->parent = c;
-        if (c->compare.children) {
+        if (t == BUS_MATCH_MESSAGE_TYPE || bus_match_value_hashed(t, value_str)) {
 
                 if (t == BUS_MATCH_MESSAGE_TYPE)
                         r = hashmap_put(c->compare.children, UINT_TO_PTR(value_u8), n);
@@ -43,7 +43,7 @@ struct bus_match_node {
                         struct match_callback *callback;
                 } leaf;
                 struct {
-                        /* If this is set, then the child is NULL */
+                        /* Values are stored here if they can be hashed, and in the child list otherwise */
                         Hashmap *children;
                 } compare;
         };
@@ -1239,7 +1239,10 @@ static int part_make_space(
         if (part->allocated == 0 || sz > part->allocated) {
                 size_t new_allocated;
 
-                new_allocated = sz > 0 ? 2 * sz : 64;
+                /* Grow geometrically, but don't overshoot when a large amount is appended at once, as
+                 * happens for big arrays: doubling those would put the allocation beyond the point where
+                 * malloc() can reuse memory, and every message would have to fault in fresh pages. */
+                new_allocated = MAX3(sz, 2 * part->allocated, (size_t) 64);
                 n = realloc(part->data, new_allocated);
                 if (!n) {
                         m->poisoned = true;
@@ -1619,6 +1622,131 @@ _public_ int sd_bus_message_append_basic(sd_bus_message *m, char type, const voi
         return message_append_basic(m, type, p, NULL);
 }
 
+int bus_message_append_sv_basic(sd_bus_message *m, const char *name, char type, const void *p) {
+        struct bus_container *c;
+        size_t name_len, l = 0;
+        ssize_t align, sz;
+        uint32_t u32;
+        uint8_t *a;
+        int r;
+
+        assert(m);
+        assert(name);
+        assert(bus_type_is_basic(type));
+
+        /* Appends a complete "{sv}" dict entry with a basic value, as used for properties. If we are
+         * inside an "a{sv}" array of a dbus1 message we serialize it directly, bypassing the generic
+         * container and signature logic, otherwise we fall back to the latter. */
+
+        if (m->sealed)
+                return -EPERM;
+        if (m->poisoned)
+                return -ESTALE;
+
+        c = message_get_last_container(m);
+
+        if (BUS_MESSAGE_IS_GVARIANT(m) ||
+            type == SD_BUS_TYPE_UNIX_FD ||
+            c->enclosing != SD_BUS_TYPE_ARRAY ||
+            !streq_ptr(c->signature, "{sv}")) {
+
+                r = sd_bus_message_open_container(m, SD_BUS_TYPE_DICT_ENTRY, "sv");
+                if (r < 0)
+                        return r;
+
+                r = sd_bus_message_append_basic(m, SD_BUS_TYPE_STRING, name);
+                if (r < 0)
+                        return r;
+
+                r = sd_bus_message_open_container(m, SD_BUS_TYPE_VARIANT, CHAR_TO_STR(type));
+                if (r < 0)
+                        return r;
+
+                r = sd_bus_message_append_basic(m, type, p);
+                if (r < 0)
+                        return r;
+
+                r = sd_bus_message_close_container(m);
+                if (r < 0)
+                        return r;
+
+                return sd_bus_message_close_container(m);
+        }
+
+        switch (type) {
+
+        case SD_BUS_TYPE_STRING:
+                p = strempty(p);
+
+                _fallthrough_;
+        case SD_BUS_TYPE_OBJECT_PATH:
+                if (!p)
+                        return -EINVAL;
+
+                l = strlen(p);
+                align = 4;
+                sz = 4 + l + 1;
+                break;
+
+        case SD_BUS_TYPE_SIGNATURE:
+                p = strempty(p);
+
+                l = strlen(p);
+                align = 1;
+                sz = 1 + l + 1;
+                break;
+
+        case SD_BUS_TYPE_BOOLEAN:
+                u32 = p && *(int*) p;
+                p = &u32;
+
+                align = sz = 4;
+                break;
+
+        default:
+                align = bus_type_get_alignment(type);
+                sz = bus_type_get_size(type);
+                break;
+        }
+
+        assert(align > 0);
+        assert(sz > 0);
+
+        /* The dict entry and its key */
+        name_len = strlen(name);
+        a = message_extend_body(m, 8, 4 + name_len + 1, false, false);
+        if (!a)
+                return -ENOMEM;
+
+        *(uint32_t*) a = name_len;
+        memcpy(a + 4, name, name_len + 1);
+
+        /* The variant signature */
+        a = message_extend_body(m, 1, 3, false, false);
+        if (!a)
+                return -ENOMEM;
+
+        a[0] = 1;
+        a[1] = type;
+        a[2] = 0;
+
+        /* And the value itself */
+        a = message_extend_body(m, align, sz, false, false);
+        if (!a)
+                return -ENOMEM;
+
+        if (IN_SET(type, SD_BUS_TYPE_STRING, SD_BUS_TYPE_OBJECT_PATH)) {
+                *(uint32_t*) a = l;
+                memcpy(a + 4, p, l + 1);
+        } else if (type == SD_BUS_TYPE_SIGNATURE) {
+                a[0] = l;
+                memcpy(a + 1, p, l + 1);
+        } else
+                memcpy(a, p, sz);
+
+        return 0;
+}
+
 _public_ int sd_bus_message_append_string_space(
                 sd_bus_message *m,
                 size_t size,
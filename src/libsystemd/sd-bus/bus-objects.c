@@ -416,6 +416,27 @@ static int method_callbacks_run(
         return 1;
 }
 
+static const void *vtable_property_automatic_value(const sd_bus_vtable *v, void *userdata) {
+        assert(v);
+
+        /* Returns the value pointer to pass to sd_bus_message_append_basic() for a basic property without
+         * a getter */
+
+        switch (v->x.property.signature[0]) {
+
+        case SD_BUS_TYPE_STRING:
+        case SD_BUS_TYPE_SIGNATURE:
+                return strempty(*(char**) userdata);
+
+        case SD_BUS_TYPE_OBJECT_PATH:
+                assert(*(char**) userdata);
+                return *(char**) userdata;
+
+        default:
+                return userdata;
+        }
+}
+
 static int invoke_property_get(
                 sd_bus *bus,
                 sd_bus_slot *slot,
@@ -427,7 +448,6 @@ static int invoke_property_get(
                 void *userdata,
                 sd_bus_error *error) {
 
-        const void *p;
         int r;
 
         assert(bus);
@@ -461,24 +481,7 @@ static int invoke_property_get(
         assert(signature_is_single(v->x.property.signature, false));
         assert(bus_type_is_basic(v->x.property.signature[0]));
 
-        switch (v->x.property.signature[0]) {
-
-        case SD_BUS_TYPE_STRING:
-        case SD_BUS_TYPE_SIGNATURE:
-                p = strempty(*(char**) userdata);
-                break;
-
-        case SD_BUS_TYPE_OBJECT_PATH:
-                p = *(char**) userdata;
-                assert(p);
-                break;
-
-        default:
-                p = userdata;
-                break;
-        }
-
-        return sd_bus_message_append_basic(reply, v->x.property.signature[0], p);
+        return sd_bus_message_append_basic(reply, v->x.property.signature[0], vtable_property_automatic_value(v, userdata));
 }
 
 static int invoke_property_set(
@@ -686,11 +689,19 @@ static int vtable_append_one_property(
         assert(c);
         assert(v);
 
+        /* Properties of a basic type without a getter are the common case, hence serialize them in one go */
+        if (!v->x.property.get &&
+            v->x.property.signature[1] == 0 &&
+            bus_type_is_basic(v->x.property.signature[0]) &&
+            v->x.property.signature[0] != SD_BUS_TYPE_UNIX_FD)
+                return bus_message_append_sv_basic(reply, v->x.property.member, v->x.property.signature[0],
+                                                   vtable_property_automatic_value(v, vtable_property_convert_userdata(v, userdata)));
+
         r = sd_bus_message_open_container(reply, 'e', "sv");
         if (r < 0)
                 return r;
 
-        r = sd_bus_message_append(reply, "s", v->x.property.member);
+        r = sd_bus_message_append_basic(reply, 's', v->x.property.member);
         if (r < 0)
                 return r;
 
@@ -949,9 +960,14 @@ static int process_introspect(
                         fprintf(intro.f, " <interface name=\"%s\">\n", c->interface);
                 }
 
-                r = introspect_write_interface(&intro, c->vtable);
-                if (r < 0)
-                        goto finish;
+                /* The members of an interface only depend on its vtable, hence format them only once */
+                if (!c->introspection) {
+                        r = introspect_format_interface(c->vtable, bus->trusted, &c->introspection);
+                        if (r < 0)
+                                goto finish;
+                }
+
+                fputs(c->introspection, intro.f);
 
                 previous_interface = c->interface;
         }
@@ -32,6 +32,9 @@
 
 #define SNDBUF_SIZE (8*1024*1024)
 
+/* How much to read from the socket at once, possibly covering several messages */
+#define BUS_READ_AHEAD_SIZE (16U*1024U)
+
 static void iovec_advance(struct iovec iov[], unsigned *idx, size_t size) {
 
         while (size > 0) {
@@ -546,6 +549,7 @@ static int bus_socket_read_auth(sd_bus *b) {
                 return -ENOMEM;
 
         b->rbuffer = p;
+        b->rbuffer_allocated = n;
 
         iov = IOVEC_MAKE((uint8_t *)b->rbuffer + b->rbuffer_size, n - b->rbuffer_size);
 
@@ -1014,7 +1018,7 @@ int bus_socket_write_message(sd_bus *bus, sd_bus_message *m, size_t *idx) {
                 return r;
 
         n = m->n_iovec * sizeof(struct iovec);
-        iov = newa(struct iovec, n);
+        iov = newa(struct iovec, m->n_iovec);
         memcpy_safe(iov, m->iovec, n);
 
         j = 0;
@@ -1052,16 +1056,15 @@ int bus_socket_write_message(sd_bus *bus, sd_bus_message *m, size_t *idx) {
         return 1;
 }
 
-static int bus_socket_read_message_need(sd_bus *bus, size_t *need) {
+static int bus_socket_message_need(const void *p, size_t size, size_t *need) {
         uint32_t a, b;
         uint8_t e;
         uint64_t sum;
 
-        assert(bus);
+        assert(p || size == 0);
         assert(need);
-        assert(IN_SET(bus->state, BUS_RUNNING, BUS_HELLO));
 
-        if (bus->rbuffer_size < sizeof(struct bus_header)) {
+        if (size < sizeof(struct bus_header)) {
                 *need = sizeof(struct bus_header) + 8;
 
                 /* Minimum message size:
@@ -1083,10 +1086,10 @@ static int bus_socket_read_message_need(sd_bus *bus, size_t *need) {
                 return 0;
         }
 
-        a = ((const uint32_t*) bus->rbuffer)[1];
-        b = ((const uint32_t*) bus->rbuffer)[3];
+        memcpy(&a, (const uint8_t*) p + 4, sizeof(a));
+        memcpy(&b, (const uint8_t*) p + 12, sizeof(b));
 
-        e = ((const uint8_t*) bus->rbuffer)[0];
+        e = ((const uint8_t*) p)[0];
         if (e == BUS_LITTLE_ENDIAN) {
                 a = le32toh(a);
                 b = le32toh(b);
@@ -1104,52 +1107,122 @@ static int bus_socket_read_message_need(sd_bus *bus, size_t *need) {
         return 0;
 }
 
-static int bus_socket_make_message(sd_bus *bus, size_t size) {
-        sd_bus_message *t = NULL;
-        void *b;
-        int r;
+static size_t bus_socket_find_last_message(sd_bus *bus) {
+        size_t offset = 0;
 
         assert(bus);
-        assert(bus->rbuffer_size >= size);
-        assert(IN_SET(bus->state, BUS_RUNNING, BUS_HELLO));
 
-        r = bus_rqueue_make_room(bus);
-        if (r < 0)
-                return r;
+        /* Returns the offset of the message the last byte in rbuffer belongs to. The kernel never merges
+         * data following a chunk carrying SCM_RIGHTS into the same read, and we pass fds only along with
+         * the first chunk of a message, hence this is the message any fds we just received belong to. */
 
-        if (bus->rbuffer_size > size) {
-                b = memdup((const uint8_t*) bus->rbuffer + size,
-                           bus->rbuffer_size - size);
-                if (!b)
-                        return -ENOMEM;
-        } else
-                b = NULL;
-
-        r = bus_message_from_malloc(bus,
-                                    bus->rbuffer, size,
-                                    bus->fds, bus->n_fds,
-                                    NULL,
-                                    &t);
-        if (r == -EBADMSG) {
-                log_debug_errno(r, "Received invalid message from connection %s, dropping.", strna(bus->description));
-                free(bus->rbuffer); /* We want to drop current rbuffer and proceed with whatever remains in b */
-        } else if (r < 0) {
-                free(b);
-                return r;
+        for (;;) {
+                size_t need;
+
+                if (bus_socket_message_need((const uint8_t*) bus->rbuffer + offset, bus->rbuffer_size - offset, &need) < 0)
+                        return offset;
+
+                if (need >= bus->rbuffer_size - offset)
+                        return offset;
+
+                offset += need;
         }
+}
 
-        /* rbuffer ownership was either transferred to t, or we got EBADMSG and dropped it. */
-        bus->rbuffer = b;
-        bus->rbuffer_size -= size;
+static int bus_socket_make_messages(sd_bus *bus) {
+        size_t offset = 0;
+        int r = 0;
 
-        bus->fds = NULL;
-        bus->n_fds = 0;
+        assert(bus);
+        assert(IN_SET(bus->state, BUS_RUNNING, BUS_HELLO));
+
+        /* Turns all complete messages in rbuffer into message objects and moves any trailing partial
+         * message to the front of the buffer. Small messages are copied out, so that rbuffer may be reused
+         * for the next read; only a large message filling the whole buffer takes ownership of it. Any
+         * pending fds are attached to the message at bus->fds_offset. */
+
+        for (;;) {
+                sd_bus_message *t = NULL;
+                size_t need;
+                void *b;
+
+                r = bus_socket_message_need((const uint8_t*) bus->rbuffer + offset, bus->rbuffer_size - offset, &need);
+                if (r < 0)
+                        break;
 
-        if (t) {
-                bus->rqueue[bus->rqueue_size++] = bus_message_ref_queued(t, bus);
-                sd_bus_message_unref(t);
+                if (bus->rbuffer_size - offset < need)
+                        break;
+
+                r = bus_rqueue_make_room(bus);
+                if (r < 0)
+                        break;
+
+                if (offset == 0 && need == bus->rbuffer_size && need >= BUS_READ_AHEAD_SIZE)
+                        b = bus->rbuffer;
+                else {
+                        b = memdup((const uint8_t*) bus->rbuffer + offset, need);
+                        if (!b) {
+                                r = -ENOMEM;
+                                break;
+                        }
+                }
+
+                if (bus->n_fds > 0 && offset == bus->fds_offset)
+                        r = bus_message_from_malloc(bus,
+                                                    b, need,
+                                                    bus->fds, bus->n_fds,
+                                                    NULL,
+                                                    &t);
+                else
+                        r = bus_message_from_malloc(bus, b, need, NULL, 0, NULL, &t);
+                if (r == -EBADMSG)
+                        log_debug_errno(r, "Received invalid message from connection %s, dropping.", strna(bus->description));
+                else if (r < 0) {
+                        if (b != bus->rbuffer)
+                                free(b);
+                        break;
+                }
+
+                if (bus->n_fds > 0 && offset == bus->fds_offset) {
+                        bus->fds = NULL;
+                        bus->n_fds = 0;
+                        bus->fds_offset = 0;
+                }
+
+                if (b == bus->rbuffer) {
+                        /* rbuffer ownership was either transferred to t, or we got EBADMSG and dropped it. */
+                        if (!t)
+                                free(bus->rbuffer);
+
+                        bus->rbuffer = NULL;
+                        bus->rbuffer_size = bus->rbuffer_allocated = 0;
+                } else {
+                        if (!t)
+                                free(b);
+
+                        offset += need;
+                }
+
+                if (t) {
+                        bus->rqueue[bus->rqueue_size++] = bus_message_ref_queued(t, bus);
+                        sd_bus_message_unref(t);
+                }
+        }
+
+        if (offset > 0 && bus->rbuffer) {
+                memmove(bus->rbuffer, (const uint8_t*) bus->rbuffer + offset, bus->rbuffer_size - offset);
+                bus->rbuffer_size -= offset;
+
+                /* If we stopped early, the message pending fds belong to moved along with the rest */
+                if (bus->n_fds > 0) {
+                        assert(bus->fds_offset >= offset);
+                        bus->fds_offset -= offset;
+                }
         }
 
+        if (r < 0)
+                return r;
+
         return 1;
 }
 
@@ -1157,9 +1230,8 @@ int bus_socket_read_message(sd_bus *bus) {
         struct msghdr mh;
         struct iovec iov = {};
         ssize_t k;
-        size_t need;
+        size_t need, size;
         int r;
-        void *b;
         union {
                 struct cmsghdr cmsghdr;
                 uint8_t buf[CMSG_SPACE(sizeof(int) * BUS_FDS_MAX)];
@@ -1169,20 +1241,30 @@ int bus_socket_read_message(sd_bus *bus) {
         assert(bus);
         assert(IN_SET(bus->state, BUS_RUNNING, BUS_HELLO));
 
-        r = bus_socket_read_message_need(bus, &need);
+        r = bus_socket_message_need(bus->rbuffer, bus->rbuffer_size, &need);
         if (r < 0)
                 return r;
 
         if (bus->rbuffer_size >= need)
-                return bus_socket_make_message(bus, need);
+                return bus_socket_make_messages(bus);
 
-        b = realloc(bus->rbuffer, need);
-        if (!b)
-                return -ENOMEM;
+        /* Read as many messages as fit into the read-ahead buffer at once, unless we are still collecting
+         * the message pending fds belong to. In that case read exactly up to its end, so that any fds
+         * coming with the next read are unambiguously attached to the message following it. */
+        if (bus->rbuffer_allocated < MAX(need, BUS_READ_AHEAD_SIZE)) {
+                void *b;
 
-        bus->rbuffer = b;
+                b = realloc(bus->rbuffer, MAX(need, BUS_READ_AHEAD_SIZE));
+                if (!b)
+                        return -ENOMEM;
 
-        iov = IOVEC_MAKE((uint8_t *)bus->rbuffer + bus->rbuffer_size, need - bus->rbuffer_size);
+                bus->rbuffer = b;
+                bus->rbuffer_allocated = MAX(need, BUS_READ_AHEAD_SIZE);
+        }
+
+        size = bus->n_fds > 0 ? need : bus->rbuffer_allocated;
+
+        iov = IOVEC_MAKE((uint8_t *)bus->rbuffer + bus->rbuffer_size, size - bus->rbuffer_size);
 
         if (bus->prefer_readv)
                 k = readv(bus->input_fd, &iov, 1);
@@ -1232,6 +1314,10 @@ int bus_socket_read_message(sd_bus *bus) {
                                         return -ENOMEM;
                                 }
 
+                                /* If we read ahead, figure out which of the messages the fds belong to */
+                                if (bus->n_fds == 0)
+                                        bus->fds_offset = bus_socket_find_last_message(bus);
+
                                 for (i = 0; i < n; i++)
                                         f[bus->n_fds++] = fd_move_above_stdio(((int*) CMSG_DATA(cmsg))[i]);
                                 bus->fds = f;
@@ -1240,12 +1326,12 @@ int bus_socket_read_message(sd_bus *bus) {
                                           cmsg->cmsg_level, cmsg->cmsg_type);
         }
 
-        r = bus_socket_read_message_need(bus, &need);
+        r = bus_socket_message_need(bus->rbuffer, bus->rbuffer_size, &need);
         if (r < 0)
                 return r;
 
         if (bus->rbuffer_size >= need)
-                return bus_socket_make_message(bus, need);
+                return bus_socket_make_messages(bus);
 
         return 1;
 }
@@ -15,16 +15,41 @@
 #include "time-util.h"
 #include "util.h"
 
-#define MAX_SIZE (2*1024*1024)
+#define MAX_SIZE (64*1024*1024)
+#define N_SIGNALS 10000U
 
 static usec_t arg_loop_usec = 100 * USEC_PER_MSEC;
 
+static int method_not_supported(sd_bus_message *m, void *userdata, sd_bus_error *error) {
+        return sd_bus_error_set(error, SD_BUS_ERROR_NOT_SUPPORTED, NULL);
+}
+
+/* Only used for introspection, hence no method implementations and no property data */
+static const sd_bus_vtable benchmark_vtable[] = {
+        SD_BUS_VTABLE_START(0),
+        SD_BUS_METHOD("Start", "s", "o", method_not_supported, 0),
+        SD_BUS_METHOD("Stop", "s", "o", method_not_supported, 0),
+        SD_BUS_METHOD("Restart", "s", "o", method_not_supported, 0),
+        SD_BUS_METHOD("Kill", "si", NULL, method_not_supported, 0),
+        SD_BUS_METHOD("SetProperties", "ba(sv)", NULL, method_not_supported, 0),
+        SD_BUS_PROPERTY("Id", "s", NULL, 0, SD_BUS_VTABLE_PROPERTY_CONST),
+        SD_BUS_PROPERTY("Names", "as", NULL, 0, SD_BUS_VTABLE_PROPERTY_CONST),
+        SD_BUS_PROPERTY("Description", "s", NULL, 0, SD_BUS_VTABLE_PROPERTY_EMITS_CHANGE),
+        SD_BUS_PROPERTY("ActiveState", "s", NULL, 0, SD_BUS_VTABLE_PROPERTY_EMITS_CHANGE),
+        SD_BUS_PROPERTY("SubState", "s", NULL, 0, SD_BUS_VTABLE_PROPERTY_EMITS_CHANGE),
+        SD_BUS_PROPERTY("StateChangeTimestamp", "t", NULL, 0, SD_BUS_VTABLE_PROPERTY_EMITS_CHANGE),
+        SD_BUS_PROPERTY("Requires", "as", NULL, 0, SD_BUS_VTABLE_PROPERTY_EMITS_INVALIDATION),
+        SD_BUS_SIGNAL("Changed", "sa{sv}as", 0),
+        SD_BUS_VTABLE_END
+};
+
 typedef enum Type {
         TYPE_LEGACY,
         TYPE_DIRECT,
 } Type;
 
-static void server(sd_bus *b, size_t *result) {
+static void server(sd_bus *b, size_t *result, unsigned *n_signals, usec_t *signals_usec) {
+        usec_t first_signal = 0;
         int r;
 
         for (;;) {
@@ -54,8 +79,16 @@ static void server(sd_bus *b, size_t *result) {
                         assert_se(sd_bus_message_read(m, "t", &res) > 0);
 
                         *result = res;
+
+                        /* The burst of signals is followed directly by the Exit call */
+                        *signals_usec = first_signal > 0 ? now(CLOCK_MONOTONIC) - first_signal : 0;
                         return;
 
+                } else if (sd_bus_message_is_signal(m, "benchmark.server", "Changed")) {
+                        if (*n_signals == 0)
+                                first_signal = now(CLOCK_MONOTONIC);
+
+                        (*n_signals)++;
                 } else if (!sd_bus_message_is_signal(m, NULL, NULL))
                         assert_not_reached("Unknown method");
         }
@@ -73,6 +106,15 @@ static void transaction(sd_bus *b, size_t sz, const char *server_name) {
         assert_se(sd_bus_call(b, m, 0, NULL, &reply) >= 0);
 }
 
+static void signals(sd_bus *b) {
+        unsigned i;
+
+        /* Emit a burst of small signals without waiting in between, so that the server receives several of
+         * them per read */
+        for (i = 0; i < N_SIGNALS; i++)
+                assert_se(sd_bus_emit_signal(b, "/", "benchmark.server", "Changed", "u", i) >= 0);
+}
+
 static void client_bisect(const char *address, const char *server_name) {
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *x = NULL;
         size_t lsize, rsize, csize;
@@ -139,6 +181,8 @@ static void client_bisect(const char *address, const char *server_name) {
                         rsize = csize;
         }
 
+        signals(b);
+
         b->use_memfd = 1;
         assert_se(sd_bus_message_new_method_call(b, &x, server_name, "/", "benchmark.server", "Exit") >= 0);
         assert_se(sd_bus_message_append(x, "t", csize) >= 0);
@@ -147,6 +191,50 @@ static void client_bisect(const char *address, const char *server_name) {
         sd_bus_unref(b);
 }
 
+static void client_introspect(const char *address, const char *server_name, int fd) {
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *x = NULL;
+        unsigned n;
+        usec_t t;
+        sd_bus *b;
+        int r;
+
+        r = sd_bus_new(&b);
+        assert_se(r >= 0);
+
+        if (fd >= 0) {
+                r = sd_bus_set_fd(b, fd, fd);
+                assert_se(r >= 0);
+        } else {
+                r = sd_bus_set_address(b, address);
+                assert_se(r >= 0);
+
+                r = sd_bus_set_bus_client(b, true);
+                assert_se(r >= 0);
+        }
+
+        r = sd_bus_start(b);
+        assert_se(r >= 0);
+
+        t = now(CLOCK_MONOTONIC);
+        for (n = 0;; n++) {
+                _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
+
+                r = sd_bus_call_method(b, server_name, "/benchmark", "org.freedesktop.DBus.Introspectable", "Introspect", NULL, &reply, NULL);
+                assert_se(r >= 0);
+
+                if (now(CLOCK_MONOTONIC) >= t + arg_loop_usec)
+                        break;
+        }
+
+        printf("INTROSPECT\t%u\n", (unsigned) ((n * USEC_PER_SEC) / arg_loop_usec));
+
+        assert_se(sd_bus_message_new_method_call(b, &x, server_name, "/", "benchmark.server", "Exit") >= 0);
+        assert_se(sd_bus_message_append(x, "t", (uint64_t) n) >= 0);
+        assert_se(sd_bus_send(b, x, NULL) >= 0);
+
+        sd_bus_unref(b);
+}
+
 static void client_chart(Type type, const char *address, const char *server_name, int fd) {
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *x = NULL;
         size_t csize;
@@ -198,6 +286,8 @@ static void client_chart(Type type, const char *address, const char *server_name
                 printf("%u\n", (unsigned) ((n_memfd * USEC_PER_SEC) / arg_loop_usec));
         }
 
+        signals(b);
+
         b->use_memfd = 1;
         assert_se(sd_bus_message_new_method_call(b, &x, server_name, "/", "benchmark.server", "Exit") >= 0);
         assert_se(sd_bus_message_append(x, "t", csize) >= 0);
@@ -210,12 +300,16 @@ int main(int argc, char *argv[]) {
         enum {
                 MODE_BISECT,
                 MODE_CHART,
+                MODE_INTROSPECT,
         } mode = MODE_BISECT;
         Type type = TYPE_LEGACY;
         int i, pair[2] = { -1, -1 };
         _cleanup_free_ char *address = NULL, *server_name = NULL;
         _cleanup_close_ int bus_ref = -1;
         const char *unique;
+        char b1[FORMAT_TIMESPAN_MAX], b2[FORMAT_TIMESPAN_MAX];
+        usec_t signals_usec = 0;
+        unsigned n_signals = 0;
         cpu_set_t cpuset;
         size_t result;
         sd_bus *b;
@@ -226,6 +320,9 @@ int main(int argc, char *argv[]) {
                 if (streq(argv[i], "chart")) {
                         mode = MODE_CHART;
                         continue;
+                } else if (streq(argv[i], "introspect")) {
+                        mode = MODE_INTROSPECT;
+                        continue;
                 } else if (streq(argv[i], "legacy")) {
                         type = TYPE_LEGACY;
                         continue;
@@ -271,6 +368,9 @@ int main(int argc, char *argv[]) {
         r = sd_bus_start(b);
         assert_se(r >= 0);
 
+        r = sd_bus_add_object_vtable(b, NULL, "/benchmark", "benchmark.Unit", benchmark_vtable, NULL);
+        assert_se(r >= 0);
+
         if (type != TYPE_DIRECT) {
                 r = sd_bus_get_unique_name(b, &unique);
                 assert_se(r >= 0);
@@ -301,6 +401,10 @@ int main(int argc, char *argv[]) {
                 case MODE_CHART:
                         client_chart(type, address, server_name, pair[1]);
                         break;
+
+                case MODE_INTROSPECT:
+                        client_introspect(address, server_name, type == TYPE_DIRECT ? pair[1] : -1);
+                        break;
                 }
 
                 _exit(EXIT_SUCCESS);
@@ -310,11 +414,17 @@ int main(int argc, char *argv[]) {
         CPU_SET(1, &cpuset);
         pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
 
-        server(b, &result);
+        server(b, &result, &n_signals, &signals_usec);
 
         if (mode == MODE_BISECT)
                 printf("Copying/memfd are equally fast at %zu bytes\n", result);
 
+        if (n_signals > 0)
+                printf("Server received %u signals in %s, %s per signal\n",
+                       n_signals,
+                       format_timespan(b1, sizeof b1, signals_usec, 1),
+                       format_timespan(b2, sizeof b2, signals_usec / n_signals, 1));
+
         assert_se(waitpid(pid, NULL, 0) == pid);
 
         safe_close(pair[1]);
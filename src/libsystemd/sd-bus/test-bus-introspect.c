@@ -1,7 +1,9 @@
 /* SPDX-License-Identifier: LGPL-2.1+ */
 
+#include "alloc-util.h"
 #include "bus-introspect.h"
 #include "log.h"
+#include "string-util.h"
 #include "tests.h"
 
 static int prop_get(sd_bus *bus, const char *path, const char *interface, const char *property, sd_bus_message *reply, void *userdata, sd_bus_error *error) {
@@ -28,6 +30,7 @@ static const sd_bus_vtable vtable[] = {
 };
 
 int main(int argc, char *argv[]) {
+        _cleanup_free_ char *formatted = NULL;
         struct introspect intro;
 
         test_setup_logging(LOG_DEBUG);
@@ -41,6 +44,10 @@ int main(int argc, char *argv[]) {
         fflush(intro.f);
         fputs(intro.introspection, stdout);
 
+        /* The standalone formatting used for caching must result in the very same data */
+        assert_se(introspect_format_interface(vtable, false, &formatted) >= 0);
+        assert_se(strstr(intro.introspection, formatted));
+
         introspect_free(&intro);
 
         return 0;
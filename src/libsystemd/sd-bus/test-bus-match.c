@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: LGPL-2.1+ */
 
+#include "alloc-util.h"
 #include "bus-match.h"
 #include "bus-message.h"
 #include "bus-slot.h"
@@ -7,7 +8,9 @@
 #include "log.h"
 #include "macro.h"
 #include "memory-util.h"
+#include "stdio-util.h"
 #include "tests.h"
+#include "time-util.h"
 
 static bool mask[32];
 
@@ -59,6 +62,135 @@ static int match_add(sd_bus_slot *slots, struct bus_match_node *root, const char
         return r;
 }
 
+static unsigned n_hits = 0;
+
+static int count_filter(sd_bus_message *m, void *userdata, sd_bus_error *ret_error) {
+        n_hits++;
+        return 0;
+}
+
+static void test_match_benchmark(sd_bus *bus) {
+        struct bus_match_node root = {
+                .type = BUS_MATCH_ROOT,
+        };
+        _cleanup_free_ sd_bus_slot *slots = NULL;
+        char ts[FORMAT_TIMESPAN_MAX];
+        unsigned i, n_matches, n_messages;
+        usec_t t;
+
+        /* Lots of matches of the kind a manager tracking many units or peers would install, each
+         * selecting one sender and one object path namespace */
+
+        n_matches = slow_tests_enabled() ? 50000 : 2000;
+        n_messages = slow_tests_enabled() ? 200000 : 20000;
+
+        assert_se(slots = new0(sd_bus_slot, n_matches));
+
+        for (i = 0; i < n_matches; i++) {
+                struct bus_match_component *components = NULL;
+                unsigned n_components = 0;
+                char match[128];
+
+                xsprintf(match, "type='signal',sender=':1.%u',path_namespace='/org/example/unit/u%u'", i, i);
+                assert_se(bus_match_parse(match, &components, &n_components) >= 0);
+
+                slots[i].match_callback.callback = count_filter;
+                assert_se(bus_match_add(&root, components, n_components, &slots[i].match_callback) >= 0);
+                bus_match_parse_free(components, n_components);
+        }
+
+        t = now(CLOCK_MONOTONIC);
+
+        for (i = 0; i < n_messages; i++) {
+                _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL;
+                char path[64], sender[32];
+                unsigned k = i % n_matches;
+
+                xsprintf(path, "/org/example/unit/u%u/sub", k);
+                xsprintf(sender, ":1.%u", k);
+
+                assert_se(sd_bus_message_new_signal(bus, &m, path, "org.example.Unit", "Changed") >= 0);
+                assert_se(sd_bus_message_set_sender(m, sender) >= 0);
+                assert_se(sd_bus_message_seal(m, 1, 0) >= 0);
+
+                n_hits = 0;
+                assert_se(bus_match_run(NULL, &root, m) == 0);
+                assert_se(n_hits == 1);
+        }
+
+        t = now(CLOCK_MONOTONIC) - t;
+        log_info("Dispatched %u messages against %u matches in %s.",
+                 n_messages, n_matches, format_timespan(ts, sizeof(ts), t, 1));
+
+        for (i = 0; i < n_matches; i++)
+                assert_se(bus_match_remove(&root, &slots[i].match_callback) >= 0);
+
+        assert_se(!root.child);
+}
+
+static unsigned n_runs[4];
+
+static int runs_filter(sd_bus_message *m, void *userdata, sd_bus_error *ret_error) {
+        assert_se(PTR_TO_UINT(userdata) < ELEMENTSOF(n_runs));
+        n_runs[PTR_TO_UINT(userdata)]++;
+        return 0;
+}
+
+static void test_match_consecutive_separators(sd_bus *bus) {
+        struct bus_match_node root = {
+                .type = BUS_MATCH_ROOT,
+        };
+        static const char *const matches[] = {
+                "arg0namespace='a'",
+                "arg0namespace='a.'",
+                "arg0namespace='a..'",
+                "arg0namespace='a..b'",
+        };
+        static const struct {
+                const char *value;
+                unsigned n_runs[ELEMENTSOF(matches)];
+        } values[] = {
+                { "a..b", { 1, 1, 1, 1 } },
+                { "a..",  { 1, 1, 1, 0 } },
+                { "a.",   { 1, 1, 0, 0 } },
+        };
+        sd_bus_slot slots[ELEMENTSOF(matches)] = {};
+        unsigned i, j;
+
+        /* With two separators in a row, the prefix ending right after the first one is also the prefix
+         * ending right before the second one. Each match must still run only once. */
+
+        for (i = 0; i < ELEMENTSOF(matches); i++) {
+                struct bus_match_component *components = NULL;
+                unsigned n_components = 0;
+
+                assert_se(bus_match_parse(matches[i], &components, &n_components) >= 0);
+
+                slots[i].userdata = UINT_TO_PTR(i);
+                slots[i].match_callback.callback = runs_filter;
+                assert_se(bus_match_add(&root, components, n_components, &slots[i].match_callback) >= 0);
+                bus_match_parse_free(components, n_components);
+        }
+
+        for (j = 0; j < ELEMENTSOF(values); j++) {
+                _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL;
+
+                assert_se(sd_bus_message_new_signal(bus, &m, "/foo", "bar.x", "waldo") >= 0);
+                assert_se(sd_bus_message_append(m, "s", values[j].value) >= 0);
+                assert_se(sd_bus_message_seal(m, 1, 0) >= 0);
+
+                zero(n_runs);
+                assert_se(bus_match_run(NULL, &root, m) == 0);
+
+                for (i = 0; i < ELEMENTSOF(matches); i++) {
+                        log_info("%s ran %u times for '%s'", matches[i], n_runs[i], values[j].value);
+                        assert_se(n_runs[i] == values[j].n_runs[i]);
+                }
+        }
+
+        bus_match_free(&root);
+}
+
 static void test_match_scope(const char *match, enum bus_match_scope scope) {
         struct bus_match_component *components = NULL;
         unsigned n_components = 0;
@@ -76,7 +208,7 @@ int main(int argc, char *argv[]) {
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL;
         _cleanup_(sd_bus_flush_close_unrefp) sd_bus *bus = NULL;
         enum bus_match_node_type i;
-        sd_bus_slot slots[19];
+        sd_bus_slot slots[26];
         int r;
 
         test_setup_logging(LOG_INFO);
@@ -105,16 +237,24 @@ int main(int argc, char *argv[]) {
         assert_se(match_add(slots, &root, "arg4has='pa'", 16) >= 0);
         assert_se(match_add(slots, &root, "arg4has='po'", 17) >= 0);
         assert_se(match_add(slots, &root, "arg4='pi'", 18) >= 0);
+        assert_se(match_add(slots, &root, "sender=':1.42'", 19) >= 0);
+        assert_se(match_add(slots, &root, "sender=':1.43'", 20) >= 0);
+        assert_se(match_add(slots, &root, "path_namespace='/'", 21) >= 0);
+        assert_se(match_add(slots, &root, "path_namespace='/foo/ba'", 22) >= 0);
+        assert_se(match_add(slots, &root, "arg3namespace='prefix.four'", 23) >= 0);
+        assert_se(match_add(slots, &root, "arg3namespace='prefix.fo'", 24) >= 0);
+        assert_se(match_add(slots, &root, "path_namespace='/foo/bar'", 25) >= 0);
 
         bus_match_dump(&root, 0);
 
         assert_se(sd_bus_message_new_signal(bus, &m, "/foo/bar", "bar.x", "waldo") >= 0);
         assert_se(sd_bus_message_append(m, "ssssas", "one", "two", "/prefix/three", "prefix.four", 3, "pi", "pa", "po") >= 0);
+        assert_se(sd_bus_message_set_sender(m, ":1.42") >= 0);
         assert_se(sd_bus_message_seal(m, 1, 0) >= 0);
 
         zero(mask);
         assert_se(bus_match_run(NULL, &root, m) == 0);
-        assert_se(mask_contains((unsigned[]) { 9, 8, 7, 5, 10, 12, 13, 14, 15, 16, 17 }, 11));
+        assert_se(mask_contains((unsigned[]) { 9, 8, 7, 5, 10, 12, 13, 14, 15, 16, 17, 19, 21, 23, 25 }, 15));
 
         assert_se(bus_match_remove(&root, &slots[8].match_callback) >= 0);
         assert_se(bus_match_remove(&root, &slots[13].match_callback) >= 0);
@@ -123,7 +263,7 @@ int main(int argc, char *argv[]) {
 
         zero(mask);
         assert_se(bus_match_run(NULL, &root, m) == 0);
-        assert_se(mask_contains((unsigned[]) { 9, 5, 10, 12, 14, 7, 15, 16, 17 }, 9));
+        assert_se(mask_contains((unsigned[]) { 9, 5, 10, 12, 14, 7, 15, 16, 17, 19, 21, 23, 25 }, 13));
 
         for (i = 0; i < _BUS_MATCH_NODE_TYPE_MAX; i++) {
                 char buf[32];
@@ -144,5 +284,8 @@ int main(int argc, char *argv[]) {
         test_match_scope("member='gurke',path='/org/freedesktop/DBus/Local'", BUS_MATCH_LOCAL);
         test_match_scope("arg2='piep',sender='org.freedesktop.DBus',member='waldo'", BUS_MATCH_DRIVER);
 
+        test_match_consecutive_separators(bus);
+        test_match_benchmark(bus);
+
         return 0;
 }
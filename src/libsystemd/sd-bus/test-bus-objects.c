@@ -281,7 +281,9 @@ static int client(struct context *c) {
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
         _cleanup_(sd_bus_unrefp) sd_bus *bus = NULL;
         _cleanup_(sd_bus_error_free) sd_bus_error error = SD_BUS_ERROR_NULL;
+        bool found_string = false, found_integer = false;
         const char *s;
+        uint32_t u;
         int r;
 
         assert_se(sd_bus_new(&bus) >= 0);
@@ -401,6 +403,30 @@ static int client(struct context *c) {
 
         bus_message_dump(reply, stdout, BUS_MESSAGE_DUMP_WITH_HEADER);
 
+        assert_se(sd_bus_message_rewind(reply, true) >= 0);
+        assert_se(sd_bus_message_enter_container(reply, 'a', "{sv}") > 0);
+        while ((r = sd_bus_message_enter_container(reply, 'e', "sv")) > 0) {
+                const char *name;
+
+                assert_se(sd_bus_message_read(reply, "s", &name) > 0);
+
+                if (streq(name, "AutomaticStringProperty")) {
+                        assert_se(sd_bus_message_read(reply, "v", "s", &s) > 0);
+                        assert_se(streq(s, "Du Dödel, Du!"));
+                        found_string = true;
+                } else if (streq(name, "AutomaticIntegerProperty")) {
+                        assert_se(sd_bus_message_read(reply, "v", "u", &u) > 0);
+                        assert_se(u == 815);
+                        found_integer = true;
+                } else
+                        assert_se(sd_bus_message_skip(reply, "v") > 0);
+
+                assert_se(sd_bus_message_exit_container(reply) > 0);
+        }
+        assert_se(r == 0);
+        assert_se(sd_bus_message_exit_container(reply) > 0);
+        assert_se(found_string && found_integer);
+
         sd_bus_message_unref(reply);
         reply = NULL;
 
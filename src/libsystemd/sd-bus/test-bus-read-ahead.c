@@ -0,0 +1,113 @@
+/* SPDX-License-Identifier: LGPL-2.1+ */
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sd-bus.h"
+
+#include "bus-internal.h"
+#include "bus-message.h"
+#include "bus-socket.h"
+#include "fd-util.h"
+#include "tests.h"
+
+#define N_SMALL 5U
+
+static void connect_pair(sd_bus **ret_client, sd_bus **ret_server) {
+        _cleanup_(sd_bus_unrefp) sd_bus *client = NULL, *server = NULL;
+        int pair[2];
+
+        assert_se(socketpair(AF_UNIX, SOCK_STREAM|SOCK_CLOEXEC, 0, pair) >= 0);
+
+        assert_se(sd_bus_new(&client) >= 0);
+        assert_se(sd_bus_set_fd(client, pair[0], pair[0]) >= 0);
+        assert_se(sd_bus_negotiate_fds(client, true) >= 0);
+        assert_se(sd_bus_start(client) >= 0);
+
+        assert_se(sd_bus_new(&server) >= 0);
+        assert_se(sd_bus_set_fd(server, pair[1], pair[1]) >= 0);
+        assert_se(sd_bus_set_server(server, true, SD_ID128_MAKE(48,25,0b,57,6a,b4,4d,4e,9b,73,21,cf,0c,5a,ce,12)) >= 0);
+        assert_se(sd_bus_negotiate_fds(server, true) >= 0);
+        assert_se(sd_bus_start(server) >= 0);
+
+        /* Both ends are in this process, hence drive the authentication on both until they are done */
+        while (sd_bus_is_ready(client) <= 0 || sd_bus_is_ready(server) <= 0) {
+                assert_se(sd_bus_process(client, NULL) >= 0);
+                assert_se(sd_bus_process(server, NULL) >= 0);
+        }
+
+        assert_se(client->can_fds && server->can_fds);
+
+        *ret_client = TAKE_PTR(client);
+        *ret_server = TAKE_PTR(server);
+}
+
+static void test_fds_after_rqueue_full(void) {
+        _cleanup_(sd_bus_unrefp) sd_bus *client = NULL, *server = NULL;
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *filler = NULL;
+        _cleanup_close_ int fd = -1;
+        struct stat st, st2;
+        unsigned i, n_fd_messages = 0;
+        size_t n;
+
+        log_info("/* %s */", __func__);
+
+        connect_pair(&client, &server);
+
+        /* A few small messages, followed by one carrying an fd. The server reads all of them at once. */
+        for (i = 0; i < N_SMALL; i++)
+                assert_se(sd_bus_emit_signal(client, "/", "test.ReadAhead", "Small", "u", i) >= 0);
+
+        fd = open("/dev/null", O_RDONLY|O_CLOEXEC);
+        assert_se(fd >= 0);
+        assert_se(fstat(fd, &st) >= 0);
+        assert_se(sd_bus_emit_signal(client, "/", "test.ReadAhead", "WithFd", "h", fd) >= 0);
+        assert_se(sd_bus_flush(client) >= 0);
+
+        /* Fill the read queue so that only two more messages fit, and the rest stays in the read buffer */
+        assert_se(sd_bus_message_new_signal(server, &filler, "/", "test.ReadAhead", "Filler") >= 0);
+        assert_se(GREEDY_REALLOC(server->rqueue, server->rqueue_allocated, BUS_RQUEUE_MAX));
+        while (server->rqueue_size < BUS_RQUEUE_MAX - 2)
+                server->rqueue[server->rqueue_size++] = bus_message_ref_queued(filler, server);
+
+        assert_se(bus_socket_read_message(server) == -ENOBUFS);
+        assert_se(server->rqueue_size == BUS_RQUEUE_MAX);
+        assert_se(server->n_fds == 1);
+
+        /* Empty the queue, and turn the rest of the buffer into messages */
+        for (n = 0; n < server->rqueue_size; n++)
+                bus_message_unref_queued(server->rqueue[n], server);
+        server->rqueue_size = 0;
+
+        assert_se(bus_socket_read_message(server) > 0);
+        assert_se(server->n_fds == 0);
+        assert_se(server->rqueue_size == N_SMALL - 2 + 1);
+
+        /* The fd must be attached to the message it was sent with, not to the first one left over */
+        for (n = 0; n < server->rqueue_size; n++) {
+                sd_bus_message *m = server->rqueue[n];
+
+                if (sd_bus_message_is_signal(m, "test.ReadAhead", "Small")) {
+                        assert_se(m->n_fds == 0);
+                        continue;
+                }
+
+                assert_se(sd_bus_message_is_signal(m, "test.ReadAhead", "WithFd"));
+                assert_se(m->n_fds == 1);
+                assert_se(fstat(m->fds[0], &st2) >= 0);
+                assert_se(st.st_dev == st2.st_dev && st.st_ino == st2.st_ino);
+                n_fd_messages++;
+        }
+
+        assert_se(n_fd_messages == 1);
+}
+
+int main(int argc, char *argv[]) {
+        test_setup_logging(LOG_INFO);
+
+        test_fds_after_rqueue_full();
+
+        return 0;
+}
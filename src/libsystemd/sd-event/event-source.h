@@ -67,6 +67,11 @@ struct sd_event_source {
         uint64_t pending_iteration;
         uint64_t prepare_iteration;
 
+        /* Dispatch statistics, all times in CLOCK_MONOTONIC */
+        uint64_t n_dispatched;
+        usec_t pending_timestamp;
+        usec_t dispatch_usec, dispatch_max_usec, pending_usec;
+
         sd_event_destroy_t destroy_callback;
 
         LIST_FIELDS(sd_event_source, sources);
@@ -96,6 +101,8 @@ struct sd_event_source {
                         siginfo_t siginfo;
                         pid_t pid;
                         int options;
+                        int pidfd;
+                        bool registered:1; /* whether the pidfd is registered in the epoll */
                 } child;
                 struct {
                         sd_event_handler_t callback;
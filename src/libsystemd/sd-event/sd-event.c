@@ -47,6 +47,9 @@ DEFINE_PRIVATE_STRING_TABLE_LOOKUP_TO_STRING(event_source_type, int);
 
 #define EVENT_SOURCE_IS_TIME(t) IN_SET((t), SOURCE_TIME_REALTIME, SOURCE_TIME_BOOTTIME, SOURCE_TIME_MONOTONIC, SOURCE_TIME_REALTIME_ALARM, SOURCE_TIME_BOOTTIME_ALARM)
 
+/* Child sources for which we have a pidfd are watched via epoll, all others via SIGCHLD and waitid() */
+#define EVENT_SOURCE_WATCH_PIDFD(s) ((s)->type == SOURCE_CHILD && (s)->child.pidfd >= 0)
+
 struct sd_event {
         unsigned n_ref;
 
@@ -71,7 +74,7 @@ struct sd_event {
         Hashmap *signal_data; /* indexed by priority */
 
         Hashmap *child_sources;
-        unsigned n_enabled_child_sources;
+        unsigned n_enabled_child_sources; /* not counting the ones watched via pidfd */
 
         Set *post_sources;
 
@@ -95,6 +98,7 @@ struct sd_event {
         bool need_process_child:1;
         bool watchdog:1;
         bool profile_delays:1;
+        bool statistics:1;
 
         int exit_code;
 
@@ -105,9 +109,18 @@ struct sd_event {
 
         unsigned n_sources;
 
+        struct epoll_event *event_queue;
+        size_t event_queue_allocated;
+
         LIST_HEAD(sd_event_source, sources);
 
+        /* How many sources of the same priority, and for how long, to dispatch per iteration */
+        unsigned dispatch_max;
+        usec_t dispatch_max_usec;
+        uint64_t n_dispatched;
+
         usec_t last_run, last_log;
+        uint64_t last_log_iteration, last_log_n_dispatched;
         unsigned delays[sizeof(usec_t) * 8];
 };
 
@@ -276,6 +289,8 @@ static sd_event *event_free(sd_event *e) {
         hashmap_free(e->child_sources);
         set_free(e->post_sources);
 
+        free(e->event_queue);
+
         return mfree(e);
 }
 
@@ -327,6 +342,7 @@ _public_ int sd_event_new(sd_event** ret) {
         if (secure_getenv("SD_EVENT_PROFILE_DELAYS")) {
                 log_debug("Event loop profiling enabled. Logarithmic histogram of event loop iterations in the range 2^0 ... 2^63 us will be logged every 5s.");
                 e->profile_delays = true;
+                e->statistics = true;
         }
 
         *ret = e;
@@ -397,6 +413,55 @@ static int source_io_register(
         return 0;
 }
 
+static void source_child_pidfd_unregister(sd_event_source *s) {
+        int r;
+
+        assert(s);
+        assert(s->type == SOURCE_CHILD);
+
+        if (event_pid_changed(s->event))
+                return;
+
+        if (!s->child.registered)
+                return;
+
+        r = epoll_ctl(s->event->epoll_fd, EPOLL_CTL_DEL, s->child.pidfd, NULL);
+        if (r < 0)
+                log_debug_errno(errno, "Failed to remove source %s (type %s) from epoll: %m",
+                                strna(s->description), event_source_type_to_string(s->type));
+
+        s->child.registered = false;
+}
+
+static int source_child_pidfd_register(sd_event_source *s) {
+        struct epoll_event ev;
+        int r;
+
+        assert(s);
+        assert(s->type == SOURCE_CHILD);
+        assert(s->child.pidfd >= 0);
+
+        /* The pidfd becomes readable once the process exited, and stays readable from then on. Hence we
+         * register it in one-shot mode, so that we don't get woken up again and again for a process we
+         * already know exited but didn't get around to dispatch yet. */
+
+        ev = (struct epoll_event) {
+                .events = EPOLLIN|EPOLLONESHOT,
+                .data.ptr = s,
+        };
+
+        if (s->child.registered)
+                r = epoll_ctl(s->event->epoll_fd, EPOLL_CTL_MOD, s->child.pidfd, &ev);
+        else
+                r = epoll_ctl(s->event->epoll_fd, EPOLL_CTL_ADD, s->child.pidfd, &ev);
+        if (r < 0)
+                return -errno;
+
+        s->child.registered = true;
+
+        return 0;
+}
+
 static clockid_t event_source_type_to_clock(EventSourceType t) {
 
         switch (t) {
@@ -470,6 +535,35 @@ static struct clock_data* event_get_clock_data(sd_event *e, EventSourceType t) {
         }
 }
 
+static bool clock_data_is_head(struct clock_data *d, sd_event_source *s) {
+        assert(d);
+
+        return prioq_peek(d->earliest) == s || prioq_peek(d->latest) == s;
+}
+
+static void event_source_time_prioq_reshuffle(sd_event_source *s) {
+        struct clock_data *d;
+        bool was_head;
+
+        assert(s);
+        assert(EVENT_SOURCE_IS_TIME(s->type));
+
+        /* Called whenever the time, accuracy, pending or enable state of a timer event source changed. The
+         * timerfd only depends on the heads of the two queues, hence unless the source was or is now at the
+         * head of one of them there's no need to recalculate the wakeup time on the next iteration. */
+
+        d = event_get_clock_data(s->event, s->type);
+        assert(d);
+
+        was_head = clock_data_is_head(d, s);
+
+        prioq_reshuffle(d->earliest, s, &s->time.earliest_index);
+        prioq_reshuffle(d->latest, s, &s->time.latest_index);
+
+        if (was_head || clock_data_is_head(d, s))
+                d->needs_rearm = true;
+}
+
 static void event_free_signal_data(sd_event *e, struct signal_data *d) {
         assert(e);
 
@@ -675,9 +769,11 @@ static void source_disconnect(sd_event_source *s) {
                 d = event_get_clock_data(s->event, s->type);
                 assert(d);
 
+                if (clock_data_is_head(d, s))
+                        d->needs_rearm = true;
+
                 prioq_remove(d->earliest, s, &s->time.earliest_index);
                 prioq_remove(d->latest, s, &s->time.latest_index);
-                d->needs_rearm = true;
                 break;
         }
 
@@ -693,12 +789,15 @@ static void source_disconnect(sd_event_source *s) {
                 break;
 
         case SOURCE_CHILD:
-                if (s->child.pid > 0) {
-                        if (s->enabled != SD_EVENT_OFF) {
-                                assert(s->event->n_enabled_child_sources > 0);
-                                s->event->n_enabled_child_sources--;
-                        }
+                if (EVENT_SOURCE_WATCH_PIDFD(s)) {
+                        source_child_pidfd_unregister(s);
+                        s->child.pidfd = safe_close(s->child.pidfd);
+                } else if (s->child.pid > 0 && s->enabled != SD_EVENT_OFF) {
+                        assert(s->event->n_enabled_child_sources > 0);
+                        s->event->n_enabled_child_sources--;
+                }
 
+                if (s->child.pid > 0) {
                         (void) hashmap_remove(s->event->child_sources, PID_TO_PTR(s->child.pid));
                         event_gc_signal_data(s->event, &s->priority, SIGCHLD);
                 }
@@ -802,6 +901,8 @@ static int source_set_pending(sd_event_source *s, bool b) {
 
         if (b) {
                 s->pending_iteration = s->event->iteration;
+                if (s->event->statistics)
+                        s->pending_timestamp = now(CLOCK_MONOTONIC);
 
                 r = prioq_put(s->event->pending, s, &s->pending_index);
                 if (r < 0) {
@@ -811,16 +912,8 @@ static int source_set_pending(sd_event_source *s, bool b) {
         } else
                 assert_se(prioq_remove(s->event->pending, s, &s->pending_index));
 
-        if (EVENT_SOURCE_IS_TIME(s->type)) {
-                struct clock_data *d;
-
-                d = event_get_clock_data(s->event, s->type);
-                assert(d);
-
-                prioq_reshuffle(d->earliest, s, &s->time.earliest_index);
-                prioq_reshuffle(d->latest, s, &s->time.latest_index);
-                d->needs_rearm = true;
-        }
+        if (EVENT_SOURCE_IS_TIME(s->type))
+                event_source_time_prioq_reshuffle(s);
 
         if (s->type == SOURCE_SIGNAL && !b) {
                 struct signal_data *d;
@@ -1032,8 +1125,6 @@ _public_ int sd_event_add_time(
         s->userdata = userdata;
         s->enabled = SD_EVENT_ONESHOT;
 
-        d->needs_rearm = true;
-
         r = prioq_put(d->earliest, s, &s->time.earliest_index);
         if (r < 0)
                 return r;
@@ -1042,6 +1133,9 @@ _public_ int sd_event_add_time(
         if (r < 0)
                 return r;
 
+        if (clock_data_is_head(d, s))
+                d->needs_rearm = true;
+
         if (ret)
                 *ret = s;
         TAKE_PTR(s);
@@ -1149,13 +1243,37 @@ _public_ int sd_event_add_child(
         s->child.pid = pid;
         s->child.options = options;
         s->child.callback = callback;
+        s->child.pidfd = -1;
+        s->wakeup = WAKEUP_EVENT_SOURCE;
         s->userdata = userdata;
         s->enabled = SD_EVENT_ONESHOT;
 
+        /* If we only care about the process exiting and the kernel supports it, let's watch the process via
+         * a pidfd in the epoll, so that we get woken up for this very process only, instead of having to call
+         * waitid() for every watched child whenever SIGCHLD is seen. Stopped/continued processes can only be
+         * detected via SIGCHLD, hence use that in all other cases, and if pidfds are not available. */
+        if (options == WEXITED) {
+                s->child.pidfd = pidfd_open(pid, 0);
+                if (s->child.pidfd < 0)
+                        log_debug_errno(errno, "Failed to allocate pidfd for child " PID_FMT ", watching it via SIGCHLD: %m", pid);
+        }
+
         r = hashmap_put(e->child_sources, PID_TO_PTR(pid), s);
         if (r < 0)
                 return r;
 
+        if (EVENT_SOURCE_WATCH_PIDFD(s)) {
+                r = source_child_pidfd_register(s);
+                if (r < 0)
+                        return r;
+
+                if (ret)
+                        *ret = s;
+                TAKE_PTR(s);
+
+                return 0;
+        }
+
         e->n_enabled_child_sources++;
 
         r = event_make_signal_data(e, SIGCHLD, NULL);
@@ -1718,6 +1836,28 @@ _public_ int sd_event_source_get_pending(sd_event_source *s) {
         return s->pending;
 }
 
+_public_ int sd_event_source_get_statistics(
+                sd_event_source *s,
+                uint64_t *ret_n_dispatched,
+                uint64_t *ret_dispatch_usec,
+                uint64_t *ret_dispatch_max_usec,
+                uint64_t *ret_pending_usec) {
+
+        assert_return(s, -EINVAL);
+        assert_return(!event_pid_changed(s->event), -ECHILD);
+
+        if (ret_n_dispatched)
+                *ret_n_dispatched = s->n_dispatched;
+        if (ret_dispatch_usec)
+                *ret_dispatch_usec = s->dispatch_usec;
+        if (ret_dispatch_max_usec)
+                *ret_dispatch_max_usec = s->dispatch_max_usec;
+        if (ret_pending_usec)
+                *ret_pending_usec = s->pending_usec;
+
+        return 0;
+}
+
 _public_ int sd_event_source_get_io_fd(sd_event_source *s) {
         assert_return(s, -EINVAL);
         assert_return(s->type == SOURCE_IO, -EDOM);
@@ -1992,18 +2132,10 @@ _public_ int sd_event_source_set_enabled(sd_event_source *s, int m) {
                 case SOURCE_TIME_BOOTTIME:
                 case SOURCE_TIME_MONOTONIC:
                 case SOURCE_TIME_REALTIME_ALARM:
-                case SOURCE_TIME_BOOTTIME_ALARM: {
-                        struct clock_data *d;
-
+                case SOURCE_TIME_BOOTTIME_ALARM:
                         s->enabled = m;
-                        d = event_get_clock_data(s->event, s->type);
-                        assert(d);
-
-                        prioq_reshuffle(d->earliest, s, &s->time.earliest_index);
-                        prioq_reshuffle(d->latest, s, &s->time.latest_index);
-                        d->needs_rearm = true;
+                        event_source_time_prioq_reshuffle(s);
                         break;
-                }
 
                 case SOURCE_SIGNAL:
                         s->enabled = m;
@@ -2014,6 +2146,11 @@ _public_ int sd_event_source_set_enabled(sd_event_source *s, int m) {
                 case SOURCE_CHILD:
                         s->enabled = m;
 
+                        if (EVENT_SOURCE_WATCH_PIDFD(s)) {
+                                source_child_pidfd_unregister(s);
+                                break;
+                        }
+
                         assert(s->event->n_enabled_child_sources > 0);
                         s->event->n_enabled_child_sources--;
 
@@ -2058,18 +2195,10 @@ _public_ int sd_event_source_set_enabled(sd_event_source *s, int m) {
                 case SOURCE_TIME_BOOTTIME:
                 case SOURCE_TIME_MONOTONIC:
                 case SOURCE_TIME_REALTIME_ALARM:
-                case SOURCE_TIME_BOOTTIME_ALARM: {
-                        struct clock_data *d;
-
+                case SOURCE_TIME_BOOTTIME_ALARM:
                         s->enabled = m;
-                        d = event_get_clock_data(s->event, s->type);
-                        assert(d);
-
-                        prioq_reshuffle(d->earliest, s, &s->time.earliest_index);
-                        prioq_reshuffle(d->latest, s, &s->time.latest_index);
-                        d->needs_rearm = true;
+                        event_source_time_prioq_reshuffle(s);
                         break;
-                }
 
                 case SOURCE_SIGNAL:
 
@@ -2086,6 +2215,15 @@ _public_ int sd_event_source_set_enabled(sd_event_source *s, int m) {
 
                 case SOURCE_CHILD:
 
+                        if (EVENT_SOURCE_WATCH_PIDFD(s)) {
+                                r = source_child_pidfd_register(s);
+                                if (r < 0)
+                                        return r;
+
+                                s->enabled = m;
+                                break;
+                        }
+
                         if (s->enabled == SD_EVENT_OFF)
                                 s->event->n_enabled_child_sources++;
 
@@ -2137,7 +2275,6 @@ _public_ int sd_event_source_get_time(sd_event_source *s, uint64_t *usec) {
 }
 
 _public_ int sd_event_source_set_time(sd_event_source *s, uint64_t usec) {
-        struct clock_data *d;
         int r;
 
         assert_return(s, -EINVAL);
@@ -2151,13 +2288,7 @@ _public_ int sd_event_source_set_time(sd_event_source *s, uint64_t usec) {
 
         s->time.next = usec;
 
-        d = event_get_clock_data(s->event, s->type);
-        assert(d);
-
-        prioq_reshuffle(d->earliest, s, &s->time.earliest_index);
-        prioq_reshuffle(d->latest, s, &s->time.latest_index);
-        d->needs_rearm = true;
-
+        event_source_time_prioq_reshuffle(s);
         return 0;
 }
 
@@ -2172,7 +2303,6 @@ _public_ int sd_event_source_get_time_accuracy(sd_event_source *s, uint64_t *use
 }
 
 _public_ int sd_event_source_set_time_accuracy(sd_event_source *s, uint64_t usec) {
-        struct clock_data *d;
         int r;
 
         assert_return(s, -EINVAL);
@@ -2190,12 +2320,7 @@ _public_ int sd_event_source_set_time_accuracy(sd_event_source *s, uint64_t usec
 
         s->time.accuracy = usec;
 
-        d = event_get_clock_data(s->event, s->type);
-        assert(d);
-
-        prioq_reshuffle(d->latest, s, &s->time.latest_index);
-        d->needs_rearm = true;
-
+        event_source_time_prioq_reshuffle(s);
         return 0;
 }
 
@@ -2481,13 +2606,10 @@ static int process_timer(
                     s->pending)
                         break;
 
+                /* This reshuffles the source in the queues, moving it behind the non-pending ones */
                 r = source_set_pending(s, true);
                 if (r < 0)
                         return r;
-
-                prioq_reshuffle(d->earliest, s, &s->time.earliest_index);
-                prioq_reshuffle(d->latest, s, &s->time.latest_index);
-                d->needs_rearm = true;
         }
 
         return 0;
@@ -2529,6 +2651,10 @@ static int process_child(sd_event *e) {
                 if (s->enabled == SD_EVENT_OFF)
                         continue;
 
+                /* Children we have a pidfd for are taken care of by process_pidfd() */
+                if (EVENT_SOURCE_WATCH_PIDFD(s))
+                        continue;
+
                 zero(s->child.siginfo);
                 r = waitid(P_PID, s->child.pid, &s->child.siginfo,
                            WNOHANG | (s->child.options & WEXITED ? WNOWAIT : 0) | s->child.options);
@@ -2557,6 +2683,32 @@ static int process_child(sd_event *e) {
         return 0;
 }
 
+static int process_pidfd(sd_event *e, sd_event_source *s, uint32_t revents) {
+        assert(e);
+        assert(s);
+        assert(s->type == SOURCE_CHILD);
+        assert(s->child.options == WEXITED);
+
+        if (s->pending)
+                return 0;
+
+        if (s->enabled == SD_EVENT_OFF)
+                return 0;
+
+        /* The pidfd became readable, hence the process exited. Let's get its exit status, but don't reap it
+         * yet, so that the callback still sees the process as a zombie. */
+
+        zero(s->child.siginfo);
+        if (waitid(P_PID, s->child.pid, &s->child.siginfo, WNOHANG|WNOWAIT|WEXITED) < 0)
+                return -errno;
+
+        if (s->child.siginfo.si_pid == 0)
+                /* Nothing to see yet? Then rearm the one-shot watch. */
+                return source_child_pidfd_register(s);
+
+        return source_set_pending(s, true);
+}
+
 static int process_signal(sd_event *e, struct signal_data *d, uint32_t events) {
         bool read_one = false;
         int r;
@@ -2775,6 +2927,8 @@ static int process_inotify(sd_event *e) {
 
 static int source_dispatch(sd_event_source *s) {
         EventSourceType saved_type;
+        usec_t begin = 0, end;
+        bool statistics;
         int r = 0;
 
         assert(s);
@@ -2815,6 +2969,14 @@ static int source_dispatch(sd_event_source *s) {
 
         s->dispatching = true;
 
+        /* Collecting statistics costs a few clock reads per dispatch, hence only do so if asked to */
+        statistics = s->event->statistics;
+        if (statistics) {
+                begin = now(CLOCK_MONOTONIC);
+                if (s->pending_timestamp > 0)
+                        s->pending_usec += usec_sub_unsigned(begin, s->pending_timestamp);
+        }
+
         switch (s->type) {
 
         case SOURCE_IO:
@@ -2841,9 +3003,15 @@ static int source_dispatch(sd_event_source *s) {
                 r = s->child.callback(s, &s->child.siginfo, s->userdata);
 
                 /* Now, reap the PID for good. */
-                if (zombie)
+                if (zombie) {
                         (void) waitid(P_PID, s->child.pid, &s->child.siginfo, WNOHANG|WEXITED);
 
+                        /* The pidfd of a reaped process stays readable forever, make sure we don't
+                         * busy loop on it should the event source be left enabled. */
+                        if (EVENT_SOURCE_WATCH_PIDFD(s))
+                                source_child_pidfd_unregister(s);
+                }
+
                 break;
         }
 
@@ -2889,6 +3057,16 @@ static int source_dispatch(sd_event_source *s) {
 
         s->dispatching = false;
 
+        if (statistics) {
+                end = now(CLOCK_MONOTONIC);
+                s->n_dispatched++;
+                s->dispatch_usec += end - begin;
+                s->dispatch_max_usec = MAX(s->dispatch_max_usec, end - begin);
+
+                /* Defer sources stay pending, count their waiting time from the end of this dispatch */
+                s->pending_timestamp = s->pending ? end : 0;
+        }
+
         if (r < 0)
                 log_debug_errno(r, "Event source %s (type %s) returned error, disabling: %m",
                                 strna(s->description), event_source_type_to_string(saved_type));
@@ -3093,7 +3271,6 @@ pending:
 }
 
 _public_ int sd_event_wait(sd_event *e, uint64_t timeout) {
-        struct epoll_event *ev_queue;
         unsigned ev_queue_max;
         int r, m, i;
 
@@ -3108,14 +3285,20 @@ _public_ int sd_event_wait(sd_event *e, uint64_t timeout) {
                 return 1;
         }
 
+        /* The queue is kept around between iterations rather than allocated on the stack: with many
+         * thousands of sources a stack allocation sized by their number might not fit into the stack
+         * of a thread running its own event loop. */
         ev_queue_max = MAX(e->n_sources, 1u);
-        ev_queue = newa(struct epoll_event, ev_queue_max);
+        if (!GREEDY_REALLOC(e->event_queue, e->event_queue_allocated, ev_queue_max)) {
+                r = -ENOMEM;
+                goto finish;
+        }
 
         /* If we still have inotify data buffered, then query the other fds, but don't wait on it */
         if (e->inotify_data_buffered)
                 timeout = 0;
 
-        m = epoll_wait(e->epoll_fd, ev_queue, ev_queue_max,
+        m = epoll_wait(e->epoll_fd, e->event_queue, ev_queue_max,
                        timeout == (uint64_t) -1 ? -1 : (int) DIV_ROUND_UP(timeout, USEC_PER_MSEC));
         if (m < 0) {
                 if (errno == EINTR) {
@@ -3131,29 +3314,35 @@ _public_ int sd_event_wait(sd_event *e, uint64_t timeout) {
 
         for (i = 0; i < m; i++) {
 
-                if (ev_queue[i].data.ptr == INT_TO_PTR(SOURCE_WATCHDOG))
-                        r = flush_timer(e, e->watchdog_fd, ev_queue[i].events, NULL);
+                if (e->event_queue[i].data.ptr == INT_TO_PTR(SOURCE_WATCHDOG))
+                        r = flush_timer(e, e->watchdog_fd, e->event_queue[i].events, NULL);
                 else {
-                        WakeupType *t = ev_queue[i].data.ptr;
+                        WakeupType *t = e->event_queue[i].data.ptr;
 
                         switch (*t) {
 
-                        case WAKEUP_EVENT_SOURCE:
-                                r = process_io(e, ev_queue[i].data.ptr, ev_queue[i].events);
+                        case WAKEUP_EVENT_SOURCE: {
+                                sd_event_source *s = e->event_queue[i].data.ptr;
+
+                                if (s->type == SOURCE_CHILD)
+                                        r = process_pidfd(e, s, e->event_queue[i].events);
+                                else
+                                        r = process_io(e, s, e->event_queue[i].events);
                                 break;
+                        }
 
                         case WAKEUP_CLOCK_DATA: {
-                                struct clock_data *d = ev_queue[i].data.ptr;
-                                r = flush_timer(e, d->fd, ev_queue[i].events, &d->next);
+                                struct clock_data *d = e->event_queue[i].data.ptr;
+                                r = flush_timer(e, d->fd, e->event_queue[i].events, &d->next);
                                 break;
                         }
 
                         case WAKEUP_SIGNAL_DATA:
-                                r = process_signal(e, ev_queue[i].data.ptr, ev_queue[i].events);
+                                r = process_signal(e, e->event_queue[i].data.ptr, e->event_queue[i].events);
                                 break;
 
                         case WAKEUP_INOTIFY_DATA:
-                                r = event_inotify_data_read(e, ev_queue[i].data.ptr, ev_queue[i].events);
+                                r = event_inotify_data_read(e, e->event_queue[i].data.ptr, e->event_queue[i].events);
                                 break;
 
                         default:
@@ -3231,6 +3420,7 @@ _public_ int sd_event_dispatch(sd_event *e) {
 
                 ref = sd_event_ref(e);
                 e->state = SD_EVENT_RUNNING;
+                e->n_dispatched++;
                 r = source_dispatch(p);
                 e->state = SD_EVENT_INITIAL;
                 return r;
@@ -3241,6 +3431,68 @@ _public_ int sd_event_dispatch(sd_event *e) {
         return 1;
 }
 
+static int event_dispatch_batch(sd_event *e, int64_t priority) {
+        _cleanup_(sd_event_unrefp) sd_event *ref = NULL;
+        usec_t begin = 0;
+        unsigned n;
+        int r;
+
+        assert(e);
+
+        /* Continues dispatching further pending sources of the same priority as the one just dispatched,
+         * without going through the prepare callbacks and epoll_wait() again for each of them, until the
+         * configured count or time budget is used up. Post sources are left for the next iteration, so that
+         * they still run after the sources that triggered them. */
+
+        if (e->dispatch_max <= 1)
+                return 0;
+
+        if (e->dispatch_max_usec > 0)
+                begin = now(CLOCK_MONOTONIC);
+
+        ref = sd_event_ref(e);
+
+        for (n = 1; n < e->dispatch_max; n++) {
+                sd_event_source *p;
+
+                if (e->state != SD_EVENT_INITIAL || e->exit_requested)
+                        break;
+
+                p = event_next_pending(e);
+                if (!p || p->priority != priority || p->type == SOURCE_POST)
+                        break;
+
+                if (e->dispatch_max_usec > 0 && now(CLOCK_MONOTONIC) - begin >= e->dispatch_max_usec)
+                        break;
+
+                e->state = SD_EVENT_RUNNING;
+                e->n_dispatched++;
+                r = source_dispatch(p);
+                e->state = SD_EVENT_INITIAL;
+                if (r < 0)
+                        return r;
+        }
+
+        return 0;
+}
+
+static void event_log_source_statistics(sd_event *e) {
+        sd_event_source *s;
+
+        LIST_FOREACH(sources, s, e->sources) {
+                char a[FORMAT_TIMESPAN_MAX], b[FORMAT_TIMESPAN_MAX], c[FORMAT_TIMESPAN_MAX];
+
+                if (s->n_dispatched == 0)
+                        continue;
+
+                log_debug("Event source %s (type %s): dispatched %" PRIu64 " times, callbacks took %s (max %s), pending for %s",
+                          strna(s->description), event_source_type_to_string(s->type), s->n_dispatched,
+                          format_timespan(a, sizeof a, s->dispatch_usec, 1),
+                          format_timespan(b, sizeof b, s->dispatch_max_usec, 1),
+                          format_timespan(c, sizeof c, s->pending_usec, 1));
+        }
+}
+
 static void event_log_delays(sd_event *e) {
         char b[ELEMENTSOF(e->delays) * DECIMAL_STR_MAX(unsigned) + 1];
         unsigned i;
@@ -3251,6 +3503,13 @@ static void event_log_delays(sd_event *e) {
                 e->delays[i] = 0;
         }
         log_debug("Event loop iterations: %.*s", o, b);
+        log_debug("Dispatched %" PRIu64 " event sources in %" PRIu64 " iterations.",
+                  e->n_dispatched - e->last_log_n_dispatched, e->iteration - e->last_log_iteration);
+
+        e->last_log_n_dispatched = e->n_dispatched;
+        e->last_log_iteration = e->iteration;
+
+        event_log_source_statistics(e);
 }
 
 _public_ int sd_event_run(sd_event *e, uint64_t timeout) {
@@ -3287,11 +3546,23 @@ _public_ int sd_event_run(sd_event *e, uint64_t timeout) {
                 e->last_run = now(CLOCK_MONOTONIC);
 
         if (r > 0) {
+                sd_event_source *p;
+                int64_t priority;
+
+                p = event_next_pending(e);
+                priority = p ? p->priority : 0;
+
                 /* There's something now, then let's dispatch it */
                 r = sd_event_dispatch(e);
                 if (r < 0)
                         return r;
 
+                if (p && !e->exit_requested) {
+                        r = event_dispatch_batch(e, priority);
+                        if (r < 0)
+                                return r;
+                }
+
                 return 1;
         }
 
@@ -3487,6 +3758,46 @@ _public_ int sd_event_get_watchdog(sd_event *e) {
         return e->watchdog;
 }
 
+_public_ int sd_event_set_statistics(sd_event *e, int b) {
+        assert_return(e, -EINVAL);
+        assert_return(e = event_resolve(e), -ENOPKG);
+        assert_return(!event_pid_changed(e), -ECHILD);
+
+        e->statistics = b;
+        return e->statistics;
+}
+
+_public_ int sd_event_get_statistics(sd_event *e) {
+        assert_return(e, -EINVAL);
+        assert_return(e = event_resolve(e), -ENOPKG);
+        assert_return(!event_pid_changed(e), -ECHILD);
+
+        return e->statistics;
+}
+
+_public_ int sd_event_set_dispatch_budget(sd_event *e, unsigned n, uint64_t usec) {
+        assert_return(e, -EINVAL);
+        assert_return(e = event_resolve(e), -ENOPKG);
+        assert_return(e->state != SD_EVENT_FINISHED, -ESTALE);
+        assert_return(!event_pid_changed(e), -ECHILD);
+
+        e->dispatch_max = MAX(n, 1U);
+        e->dispatch_max_usec = usec == USEC_INFINITY ? 0 : usec;
+        return 0;
+}
+
+_public_ int sd_event_get_dispatch_budget(sd_event *e, unsigned *ret_n, uint64_t *ret_usec) {
+        assert_return(e, -EINVAL);
+        assert_return(e = event_resolve(e), -ENOPKG);
+        assert_return(!event_pid_changed(e), -ECHILD);
+
+        if (ret_n)
+                *ret_n = MAX(e->dispatch_max, 1U);
+        if (ret_usec)
+                *ret_usec = e->dispatch_max_usec;
+        return 0;
+}
+
 _public_ int sd_event_get_iteration(sd_event *e, uint64_t *ret) {
         assert_return(e, -EINVAL);
         assert_return(e = event_resolve(e), -ENOPKG);
@@ -1,5 +1,7 @@
 /* SPDX-License-Identifier: LGPL-2.1+ */
 
+#include <pthread.h>
+#include <sys/eventfd.h>
 #include <sys/wait.h>
 
 #include "sd-event.h"
@@ -11,6 +13,8 @@
 #include "macro.h"
 #include "parse-util.h"
 #include "process-util.h"
+#include "random-util.h"
+#include "rlimit-util.h"
 #include "rm-rf.h"
 #include "signal-util.h"
 #include "stdio-util.h"
@@ -481,15 +485,295 @@ static void test_inotify(unsigned n_create_events) {
         sd_event_unref(e);
 }
 
+static pid_t *children = NULL;
+static unsigned n_children = 0, n_children_reaped = 0;
+
+static int many_children_handler(sd_event_source *s, const siginfo_t *si, void *userdata) {
+        sd_event *e = sd_event_source_get_event(s);
+
+        assert_se(s);
+        assert_se(si);
+
+        /* The children are killed one after the other, so that each SIGCHLD only concerns a single child */
+        assert_se(n_children_reaped < n_children);
+        assert_se(si->si_pid == children[n_children_reaped]);
+        assert_se(si->si_code == CLD_KILLED);
+        assert_se(si->si_status == SIGKILL);
+
+        sd_event_source_unref(s);
+
+        if (++n_children_reaped == n_children)
+                return sd_event_exit(e, 0);
+
+        assert_se(kill(children[n_children_reaped], SIGKILL) >= 0);
+        return 1;
+}
+
+static void test_many_children(void) {
+        _cleanup_(sd_event_unrefp) sd_event *e = NULL;
+        char b[FORMAT_TIMESPAN_MAX];
+        unsigned i;
+        usec_t ts;
+
+        n_children = slow_tests_enabled() ? 10000 : 100;
+        log_info("/* %s(%u) */", __func__, n_children);
+
+        /* Each watched child might take up one fd for its pidfd */
+        (void) rlimit_nofile_bump(-1);
+
+        assert_se(sigprocmask_many(SIG_BLOCK, NULL, SIGCHLD, -1) >= 0);
+        assert_se(sd_event_default(&e) >= 0);
+
+        assert_se(children = new(pid_t, n_children));
+
+        for (i = 0; i < n_children; i++) {
+                children[i] = fork();
+                assert_se(children[i] >= 0);
+                if (children[i] == 0)
+                        for (;;)
+                                pause();
+        }
+
+        ts = now(CLOCK_MONOTONIC);
+
+        for (i = 0; i < n_children; i++)
+                assert_se(sd_event_add_child(e, NULL, children[i], WEXITED, many_children_handler, NULL) >= 0);
+
+        assert_se(kill(children[0], SIGKILL) >= 0);
+        assert_se(sd_event_loop(e) >= 0);
+        assert_se(n_children_reaped == n_children);
+
+        log_info("Watching %u children took %s", n_children, format_timespan(b, sizeof b, now(CLOCK_MONOTONIC) - ts, 0));
+
+        children = mfree(children);
+}
+
+static int many_timers_handler(sd_event_source *s, uint64_t usec, void *userdata) {
+        unsigned *n_fired = userdata;
+
+        (*n_fired)++;
+        return 0;
+}
+
+static void test_many_timers(void) {
+        _cleanup_(sd_event_unrefp) sd_event *e = NULL;
+        char b[FORMAT_TIMESPAN_MAX];
+        sd_event_source **sources;
+        unsigned n, i, n_fired = 0;
+        usec_t base, ts;
+
+        n = slow_tests_enabled() ? 100000 : 1000;
+        log_info("/* %s(%u) */", __func__, n);
+
+        assert_se(sd_event_new(&e) >= 0);
+        assert_se(sources = new(sd_event_source*, n));
+
+        base = now(CLOCK_MONOTONIC);
+        for (i = 0; i < n; i++)
+                assert_se(sd_event_add_time(e, sources + i, CLOCK_MONOTONIC, base + USEC_PER_HOUR + i * USEC_PER_MSEC, 0,
+                                            many_timers_handler, &n_fired) >= 0);
+
+        /* Move the timers around, like the reply timeouts of bus method calls or lease timers would be, and
+         * let the event loop recalculate its wakeup time in between */
+        ts = now(CLOCK_MONOTONIC);
+        for (i = 0; i < n * 10; i++) {
+                assert_se(sd_event_source_set_time(sources[random_u64() % n], base + USEC_PER_HOUR + random_u64() % USEC_PER_HOUR) >= 0);
+                assert_se(sd_event_run(e, 0) >= 0);
+        }
+        log_info("Updating %u timers %u times took %s", n, n * 10, format_timespan(b, sizeof b, now(CLOCK_MONOTONIC) - ts, 0));
+
+        assert_se(n_fired == 0);
+
+        /* Now let all of them elapse */
+        for (i = 0; i < n; i++)
+                assert_se(sd_event_source_set_time(sources[i], base) >= 0);
+        while (n_fired < n)
+                assert_se(sd_event_run(e, (uint64_t) -1) >= 0);
+
+        for (i = 0; i < n; i++)
+                sd_event_source_unref(sources[i]);
+        free(sources);
+}
+
+static int thread_io_handler(sd_event_source *s, int fd, uint32_t revents, void *userdata) {
+        unsigned *n_left = userdata;
+        uint64_t x;
+
+        assert_se(read(fd, &x, sizeof(x)) == sizeof(x));
+        assert_se(x == 1);
+
+        assert_se(sd_event_source_set_enabled(s, SD_EVENT_OFF) >= 0);
+        safe_close(fd);
+
+        if (--(*n_left) == 0)
+                return sd_event_exit(sd_event_source_get_event(s), 0);
+
+        return 0;
+}
+
+static void *event_thread(void *p) {
+        _cleanup_(sd_event_unrefp) sd_event *e = NULL;
+        unsigned n = PTR_TO_UINT(p), n_left = n, i;
+
+        assert_se(sd_event_new(&e) >= 0);
+
+        for (i = 0; i < n; i++) {
+                int fd;
+
+                fd = eventfd(1, EFD_CLOEXEC|EFD_NONBLOCK);
+                assert_se(fd >= 0);
+
+                assert_se(sd_event_add_io(e, NULL, fd, EPOLLIN, thread_io_handler, &n_left) >= 0);
+        }
+
+        assert_se(sd_event_loop(e) >= 0);
+        assert_se(n_left == 0);
+
+        return NULL;
+}
+
+static void test_threads(void) {
+        pthread_t threads[4];
+        pthread_attr_t attr;
+        char b[FORMAT_TIMESPAN_MAX];
+        unsigned n, i;
+        usec_t ts;
+
+        n = slow_tests_enabled() ? 4000 : 500;
+        log_info("/* %s(%u) */", __func__, n);
+
+        (void) rlimit_nofile_bump(-1);
+
+        /* Run a separate event loop with many sources in each thread, on a stack much smaller than the
+         * default, as threaded daemons might configure it */
+        assert_se(pthread_attr_init(&attr) == 0);
+        assert_se(pthread_attr_setstacksize(&attr, 64U * 1024U) == 0);
+
+        ts = now(CLOCK_MONOTONIC);
+
+        for (i = 0; i < ELEMENTSOF(threads); i++)
+                assert_se(pthread_create(threads + i, &attr, event_thread, UINT_TO_PTR(n)) == 0);
+
+        for (i = 0; i < ELEMENTSOF(threads); i++)
+                assert_se(pthread_join(threads[i], NULL) == 0);
+
+        log_info("Dispatching %u sources in each of %zu threads took %s",
+                 n, ELEMENTSOF(threads), format_timespan(b, sizeof b, now(CLOCK_MONOTONIC) - ts, 0));
+
+        assert_se(pthread_attr_destroy(&attr) == 0);
+}
+
+static int statistics_handler(sd_event_source *s, void *userdata) {
+        usleep(1000);
+        return 0;
+}
+
+static void test_statistics(void) {
+        _cleanup_(sd_event_unrefp) sd_event *e = NULL;
+        _cleanup_(sd_event_source_unrefp) sd_event_source *s = NULL;
+        uint64_t n, dispatch, dispatch_max, pending;
+        unsigned i;
+
+        log_info("/* %s */", __func__);
+
+        assert_se(sd_event_new(&e) >= 0);
+        assert_se(sd_event_add_defer(e, &s, statistics_handler, NULL) >= 0);
+        assert_se(sd_event_source_set_enabled(s, SD_EVENT_ON) >= 0);
+
+        /* Nothing is collected unless asked for */
+        if (!getenv("SD_EVENT_PROFILE_DELAYS")) {
+                assert_se(sd_event_get_statistics(e) == 0);
+
+                assert_se(sd_event_run(e, 0) > 0);
+                assert_se(sd_event_source_get_statistics(s, &n, &dispatch, &dispatch_max, &pending) >= 0);
+                assert_se(n == 0);
+                assert_se(dispatch == 0);
+                assert_se(dispatch_max == 0);
+                assert_se(pending == 0);
+        }
+
+        assert_se(sd_event_set_statistics(e, true) > 0);
+        assert_se(sd_event_get_statistics(e) > 0);
+
+        for (i = 0; i < 5; i++)
+                assert_se(sd_event_run(e, 0) > 0);
+
+        assert_se(sd_event_source_get_statistics(s, &n, &dispatch, &dispatch_max, NULL) >= 0);
+        assert_se(n == 5);
+        assert_se(dispatch >= 5 * USEC_PER_MSEC);
+        assert_se(dispatch_max >= USEC_PER_MSEC);
+        assert_se(dispatch_max <= dispatch);
+}
+
+static void run_dispatch_budget(unsigned n, unsigned budget, uint64_t *ret_iterations, usec_t *ret_usec) {
+        _cleanup_(sd_event_unrefp) sd_event *e = NULL;
+        unsigned n_left = n, i, k;
+        uint64_t first, last, usec;
+        usec_t ts;
+
+        assert_se(sd_event_new(&e) >= 0);
+        assert_se(sd_event_set_dispatch_budget(e, budget, 0) >= 0);
+        assert_se(sd_event_get_dispatch_budget(e, &k, &usec) >= 0);
+        assert_se(k == budget);
+        assert_se(usec == 0);
+
+        for (i = 0; i < n; i++) {
+                int fd;
+
+                fd = eventfd(1, EFD_CLOEXEC|EFD_NONBLOCK);
+                assert_se(fd >= 0);
+
+                assert_se(sd_event_add_io(e, NULL, fd, EPOLLIN, thread_io_handler, &n_left) >= 0);
+        }
+
+        ts = now(CLOCK_MONOTONIC);
+        assert_se(sd_event_get_iteration(e, &first) >= 0);
+
+        assert_se(sd_event_loop(e) >= 0);
+        assert_se(n_left == 0);
+
+        assert_se(sd_event_get_iteration(e, &last) >= 0);
+        *ret_iterations = last - first;
+        *ret_usec = now(CLOCK_MONOTONIC) - ts;
+}
+
+static void test_dispatch_budget(void) {
+        char b[FORMAT_TIMESPAN_MAX];
+        uint64_t iterations, iterations_batched;
+        unsigned n;
+        usec_t t;
+
+        n = slow_tests_enabled() ? 10000 : 1000;
+        log_info("/* %s(%u) */", __func__, n);
+
+        (void) rlimit_nofile_bump(-1);
+
+        run_dispatch_budget(n, 1, &iterations, &t);
+        log_info("Dispatching %u sources one per iteration took %s in %" PRIu64 " iterations",
+                 n, format_timespan(b, sizeof b, t, 0), iterations);
+        assert_se(iterations >= n);
+
+        run_dispatch_budget(n, UINT_MAX, &iterations_batched, &t);
+        log_info("Dispatching %u sources in batches took %s in %" PRIu64 " iterations",
+                 n, format_timespan(b, sizeof b, t, 0), iterations_batched);
+        assert_se(iterations_batched < iterations);
+}
+
 int main(int argc, char *argv[]) {
         test_setup_logging(LOG_DEBUG);
 
         test_basic();
         test_sd_event_now();
         test_rtqueue();
+        test_statistics();
 
         test_inotify(100); /* should work without overflow */
         test_inotify(33000); /* should trigger a q overflow */
 
+        test_many_children();
+        test_many_timers();
+        test_threads();
+        test_dispatch_budget();
+
         return 0;
 }
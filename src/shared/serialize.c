@@ -13,7 +13,21 @@
 #include "strv.h"
 #include "tmpfile-util.h"
 
+static void serialize_line(FILE *f, const char *key, size_t key_len, const char *value, size_t value_len) {
+        /* Every unit writes dozens of these, hence write the whole line under a single lock, with the lengths we
+         * already know. */
+
+        flockfile(f);
+        fwrite_unlocked(key, 1, key_len, f);
+        fputc_unlocked('=', f);
+        fwrite_unlocked(value, 1, value_len, f);
+        fputc_unlocked('\n', f);
+        funlockfile(f);
+}
+
 int serialize_item(FILE *f, const char *key, const char *value) {
+        size_t key_len, value_len;
+
         assert(f);
         assert(key);
 
@@ -22,15 +36,14 @@ int serialize_item(FILE *f, const char *key, const char *value) {
 
         /* Make sure that anything we serialize we can also read back again with read_line() with a maximum line size
          * of LONG_LINE_MAX. This is a safety net only. All code calling us should filter this out earlier anyway. */
-        if (strlen(key) + 1 + strlen(value) + 1 > LONG_LINE_MAX) {
+        key_len = strlen(key);
+        value_len = strlen(value);
+        if (key_len + 1 + value_len + 1 > LONG_LINE_MAX) {
                 log_warning("Attempted to serialize overly long item '%s', refusing.", key);
                 return -EINVAL;
         }
 
-        fputs(key, f);
-        fputc('=', f);
-        fputs(value, f);
-        fputc('\n', f);
+        serialize_line(f, key, key_len, value, value_len);
 
         return 1;
 }
@@ -53,6 +66,7 @@ int serialize_item_escaped(FILE *f, const char *key, const char *value) {
 
 int serialize_item_format(FILE *f, const char *key, const char *format, ...) {
         char buf[LONG_LINE_MAX];
+        size_t key_len;
         va_list ap;
         int k;
 
@@ -64,15 +78,13 @@ int serialize_item_format(FILE *f, const char *key, const char *format, ...) {
         k = vsnprintf(buf, sizeof(buf), format, ap);
         va_end(ap);
 
-        if (k < 0 || (size_t) k >= sizeof(buf) || strlen(key) + 1 + k + 1 > LONG_LINE_MAX) {
+        key_len = strlen(key);
+        if (k < 0 || (size_t) k >= sizeof(buf) || key_len + 1 + k + 1 > LONG_LINE_MAX) {
                 log_warning("Attempted to serialize overly long item '%s', refusing.", key);
                 return -EINVAL;
         }
 
-        fputs(key, f);
-        fputc('=', f);
-        fputs(buf, f);
-        fputc('\n', f);
+        serialize_line(f, key, key_len, buf, k);
 
         return 1;
 }
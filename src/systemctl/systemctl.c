@@ -107,6 +107,7 @@ static bool arg_no_wtmp = false;
 static bool arg_no_sync = false;
 static bool arg_no_wall = false;
 static bool arg_no_reload = false;
+static bool arg_if_changed = false;
 static bool arg_value = false;
 static bool arg_show_types = false;
 static bool arg_ignore_inhibitors = false;
@@ -5973,6 +5974,7 @@ static int daemon_reload(int argc, char *argv[], void *userdata) {
 
         case ACTION_SYSTEMCTL:
                 method = streq(argv[0], "daemon-reexec") ? "Reexecute" :
+                                     arg_if_changed ? "ReloadIfChanged" :
                                      /* "daemon-reload" */ "Reload";
                 break;
 
@@ -7615,6 +7617,8 @@ static int systemctl_help(void) {
                "     --no-block       Do not wait until operation finished\n"
                "     --no-wall        Don't send wall message before halt/power-off/reboot\n"
                "     --no-reload      Don't reload daemon after en-/dis-abling unit files\n"
+               "     --if-changed     For daemon-reload, skip the reload if no unit file\n"
+               "                      changed since the last one\n"
                "     --no-legend      Do not print a legend (column headers and hints)\n"
                "     --no-pager       Do not pipe output into a pager\n"
                "     --no-ask-password\n"
@@ -7944,6 +7948,7 @@ static int systemctl_parse_argv(int argc, char *argv[]) {
                 ARG_NO_WALL,
                 ARG_ROOT,
                 ARG_NO_RELOAD,
+                ARG_IF_CHANGED,
                 ARG_KILL_WHO,
                 ARG_NO_ASK_PASSWORD,
                 ARG_FAILED,
@@ -7991,6 +7996,7 @@ static int systemctl_parse_argv(int argc, char *argv[]) {
                 { "root",                required_argument, NULL, ARG_ROOT                },
                 { "force",               no_argument,       NULL, 'f'                     },
                 { "no-reload",           no_argument,       NULL, ARG_NO_RELOAD           },
+                { "if-changed",          no_argument,       NULL, ARG_IF_CHANGED          },
                 { "kill-who",            required_argument, NULL, ARG_KILL_WHO            },
                 { "signal",              required_argument, NULL, 's'                     },
                 { "no-ask-password",     no_argument,       NULL, ARG_NO_ASK_PASSWORD     },
@@ -8212,6 +8218,10 @@ static int systemctl_parse_argv(int argc, char *argv[]) {
                         arg_no_reload = true;
                         break;
 
+                case ARG_IF_CHANGED:
+                        arg_if_changed = true;
+                        break;
+
                 case ARG_KILL_WHO:
                         arg_kill_who = optarg;
                         break;
@@ -110,6 +110,10 @@ int sd_event_get_exit_code(sd_event *e, int *code);
 int sd_event_set_watchdog(sd_event *e, int b);
 int sd_event_get_watchdog(sd_event *e);
 int sd_event_get_iteration(sd_event *e, uint64_t *ret);
+int sd_event_set_dispatch_budget(sd_event *e, unsigned n, uint64_t usec);
+int sd_event_get_dispatch_budget(sd_event *e, unsigned *ret_n, uint64_t *ret_usec);
+int sd_event_set_statistics(sd_event *e, int b);
+int sd_event_get_statistics(sd_event *e);
 
 sd_event_source* sd_event_source_ref(sd_event_source *s);
 sd_event_source* sd_event_source_unref(sd_event_source *s);
@@ -145,6 +149,7 @@ int sd_event_source_set_destroy_callback(sd_event_source *s, sd_event_destroy_t
 int sd_event_source_get_destroy_callback(sd_event_source *s, sd_event_destroy_t *ret);
 int sd_event_source_get_floating(sd_event_source *s);
 int sd_event_source_set_floating(sd_event_source *s, int b);
+int sd_event_source_get_statistics(sd_event_source *s, uint64_t *ret_n_dispatched, uint64_t *ret_dispatch_usec, uint64_t *ret_dispatch_max_usec, uint64_t *ret_pending_usec);
 
 /* Define helpers so that __attribute__((cleanup(sd_event_unrefp))) and similar may be used. */
 _SD_DEFINE_POINTER_CLEANUP_FUNC(sd_event, sd_event_unref);
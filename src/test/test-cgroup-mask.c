@@ -4,9 +4,11 @@
 
 #include "cgroup.h"
 #include "cgroup-util.h"
+#include "hashmap.h"
 #include "macro.h"
 #include "manager.h"
 #include "rm-rf.h"
+#include "service.h"
 #include "string-util.h"
 #include "test-helper.h"
 #include "tests.h"
@@ -121,6 +123,155 @@ static int test_cgroup_mask(void) {
         return 0;
 }
 
+static int test_cgroup_siblings_queue(void) {
+        _cleanup_(rm_rf_physical_and_freep) char *runtime_dir = NULL;
+        _cleanup_(manager_freep) Manager *m = NULL;
+        Unit *son, *daughter, *grandchild, *parent, *parent_deep, *root, *u;
+        unsigned n = 0;
+        int r;
+
+        r = enter_cgroup_subroot();
+        if (r == -ENOMEDIUM)
+                return log_tests_skipped("cgroupfs not available");
+
+        assert_se(set_unit_path(get_testdata_dir()) >= 0);
+        assert_se(runtime_dir = setup_fake_runtime_dir());
+        r = manager_new(UNIT_FILE_USER, MANAGER_TEST_RUN_BASIC, &m);
+        if (IN_SET(r, -EPERM, -EACCES)) {
+                log_error_errno(r, "manager_new: %m");
+                return log_tests_skipped("cannot create manager");
+        }
+
+        assert_se(r >= 0);
+        assert_se(manager_startup(m, NULL, NULL) >= 0);
+
+        assert_se(manager_load_startable_unit_or_warn(m, "parent.slice", NULL, &parent) >= 0);
+        assert_se(manager_load_startable_unit_or_warn(m, "son.service", NULL, &son) >= 0);
+        assert_se(manager_load_startable_unit_or_warn(m, "daughter.service", NULL, &daughter) >= 0);
+        assert_se(manager_load_startable_unit_or_warn(m, "grandchild.service", NULL, &grandchild) >= 0);
+        assert_se(manager_load_startable_unit_or_warn(m, "parent-deep.slice", NULL, &parent_deep) >= 0);
+        root = UNIT_DEREF(parent->slice);
+
+        /* Only active siblings are realized, so make the daughter look like it is running */
+        SERVICE(daughter)->state = SERVICE_RUNNING;
+        assert_se(!UNIT_IS_INACTIVE_OR_FAILED(unit_active_state(daughter)));
+
+        /* Realizing a cgroup only queues the slices it is in, their members are looked at when the queue is
+         * dispatched */
+        (void) unit_realize_cgroup(son);
+        assert_se(parent->in_cgroup_siblings_queue);
+        assert_se(root->in_cgroup_siblings_queue);
+        assert_se(!parent_deep->in_cgroup_siblings_queue);
+        assert_se(!daughter->in_cgroup_realize_queue);
+        assert_se(!daughter->cgroup_realized);
+
+        /* Slices are queued only once, even if several of their members are realized */
+        (void) unit_realize_cgroup(grandchild);
+        assert_se(parent_deep->in_cgroup_siblings_queue);
+
+        LIST_FOREACH(cgroup_siblings_queue, u, m->cgroup_siblings_queue)
+                n++;
+        assert_se(n == 3);
+
+        manager_dispatch_cgroup_realize_queue(m);
+        assert_se(!m->cgroup_siblings_queue);
+        assert_se(!m->cgroup_realize_queue);
+        assert_se(!parent->in_cgroup_siblings_queue);
+        assert_se(!root->in_cgroup_siblings_queue);
+        assert_se(!parent_deep->in_cgroup_siblings_queue);
+        assert_se(daughter->cgroup_realized);
+
+        return 0;
+}
+
+static int test_cgroup_attribute_cache(void) {
+        _cleanup_(rm_rf_physical_and_freep) char *runtime_dir = NULL;
+        _cleanup_(manager_freep) Manager *m = NULL;
+        _cleanup_free_ char *k = NULL;
+        unsigned writes, skipped;
+        Unit *son;
+        int r;
+
+        r = enter_cgroup_subroot();
+        if (r == -ENOMEDIUM)
+                return log_tests_skipped("cgroupfs not available");
+
+        assert_se(set_unit_path(get_testdata_dir()) >= 0);
+        assert_se(runtime_dir = setup_fake_runtime_dir());
+        r = manager_new(UNIT_FILE_USER, MANAGER_TEST_RUN_BASIC, &m);
+        if (IN_SET(r, -EPERM, -EACCES)) {
+                log_error_errno(r, "manager_new: %m");
+                return log_tests_skipped("cannot create manager");
+        }
+
+        assert_se(r >= 0);
+        assert_se(manager_startup(m, NULL, NULL) >= 0);
+
+        assert_se(manager_load_startable_unit_or_warn(m, "son.service", NULL, &son) >= 0);
+
+        /* Point the unit to a cgroup that doesn't exist, so that every write that is actually attempted fails */
+        assert_se(unit_set_cgroup_path(son, "/test-cgroup-attribute-cache.nonexistent") >= 0);
+
+        /* Per-device attributes are cached per device, all others per attribute */
+        assert_se(k = cgroup_attribute_cache_key("cpu.weight", "100"));
+        assert_se(streq(k, "cpu.weight"));
+        k = mfree(k);
+        assert_se(k = cgroup_attribute_cache_key("io.max", "8:0 rbps=1000"));
+        assert_se(streq(k, "io.max 8:0"));
+
+        /* Writing the value we already wrote is skipped */
+        unit_cgroup_attribute_cache_update(son, "cpu.weight", "100");
+        writes = m->n_cgroup_attribute_writes;
+        skipped = m->n_cgroup_attribute_writes_skipped;
+        assert_se(unit_set_cgroup_attribute(son, "cpu", "cpu.weight", "100") == 0);
+        assert_se(m->n_cgroup_attribute_writes == writes);
+        assert_se(m->n_cgroup_attribute_writes_skipped == skipped + 1);
+
+        /* A different value is written, and as the write fails we forget what we wrote before */
+        assert_se(unit_set_cgroup_attribute(son, "cpu", "cpu.weight", "200") < 0);
+        assert_se(m->n_cgroup_attribute_writes == writes + 1);
+        assert_se(!hashmap_contains(son->cgroup_attribute_cache, "cpu.weight"));
+        assert_se(unit_set_cgroup_attribute(son, "cpu", "cpu.weight", "100") < 0);
+        assert_se(m->n_cgroup_attribute_writes == writes + 2);
+        assert_se(m->n_cgroup_attribute_writes_skipped == skipped + 1);
+
+        /* Writes for another device are not skipped, and don't touch the cached value of the first one */
+        unit_cgroup_attribute_cache_update(son, k, "8:0 rbps=1000");
+        assert_se(unit_set_cgroup_attribute(son, "io", "io.max", "8:0 rbps=1000") == 0);
+        assert_se(m->n_cgroup_attribute_writes_skipped == skipped + 2);
+        assert_se(unit_set_cgroup_attribute(son, "io", "io.max", "8:16 rbps=1000") < 0);
+        assert_se(m->n_cgroup_attribute_writes == writes + 3);
+        assert_se(streq_ptr(hashmap_get(son->cgroup_attribute_cache, "io.max 8:0"), "8:0 rbps=1000"));
+        assert_se(!hashmap_contains(son->cgroup_attribute_cache, "io.max 8:16"));
+
+        /* Flushing a controller only forgets its own attributes, "cpu." is not a prefix of "cpuacct." */
+        unit_cgroup_attribute_cache_update(son, "cpu.weight", "100");
+        unit_cgroup_attribute_cache_update(son, "cpuacct.usage", "0");
+        unit_cgroup_attribute_cache_update(son, "memory.max", "max");
+        unit_cgroup_attribute_cache_flush(son, CGROUP_MASK_CPU);
+        assert_se(!hashmap_contains(son->cgroup_attribute_cache, "cpu.weight"));
+        assert_se(hashmap_contains(son->cgroup_attribute_cache, "cpuacct.usage"));
+        assert_se(hashmap_contains(son->cgroup_attribute_cache, "memory.max"));
+        assert_se(hashmap_contains(son->cgroup_attribute_cache, "io.max 8:0"));
+        unit_cgroup_attribute_cache_flush(son, CGROUP_MASK_CPUACCT);
+        assert_se(!hashmap_contains(son->cgroup_attribute_cache, "cpuacct.usage"));
+        assert_se(hashmap_size(son->cgroup_attribute_cache) == 2);
+
+        /* Invalidating a controller makes sure its attributes are written again, compat pairs included */
+        unit_cgroup_attribute_cache_update(son, "blkio.weight", "500");
+        unit_invalidate_cgroup(son, CGROUP_MASK_IO);
+        assert_se(!hashmap_contains(son->cgroup_attribute_cache, "io.max 8:0"));
+        assert_se(!hashmap_contains(son->cgroup_attribute_cache, "blkio.weight"));
+        assert_se(streq_ptr(hashmap_get(son->cgroup_attribute_cache, "memory.max"), "max"));
+        assert_se(son->in_cgroup_realize_queue);
+
+        writes = m->n_cgroup_attribute_writes;
+        assert_se(unit_set_cgroup_attribute(son, "io", "io.max", "8:0 rbps=1000") < 0);
+        assert_se(m->n_cgroup_attribute_writes == writes + 1);
+
+        return 0;
+}
+
 static void test_cg_mask_to_string_one(CGroupMask mask, const char *t) {
         _cleanup_free_ char *b = NULL;
 
@@ -151,7 +302,11 @@ int main(int argc, char* argv[]) {
         test_setup_logging(LOG_DEBUG);
 
         test_cg_mask_to_string();
+
+        /* These return EXIT_TEST_SKIP if the environment isn't suitable, don't lose that */
         TEST_REQ_RUNNING_SYSTEMD(rc = test_cgroup_mask());
+        TEST_REQ_RUNNING_SYSTEMD(rc = rc ?: test_cgroup_siblings_queue());
+        TEST_REQ_RUNNING_SYSTEMD(rc = rc ?: test_cgroup_attribute_cache());
 
         return rc;
 }
@@ -7,8 +7,10 @@
 #include "fd-util.h"
 #include "fileio.h"
 #include "fs-util.h"
+#include "io-util.h"
 #include "log.h"
 #include "macro.h"
+#include "memory-util.h"
 #include "mkdir.h"
 #include "path-util.h"
 #include "rm-rf.h"
@@ -237,6 +239,65 @@ static void test_copy_bytes_regular_file(const char *src, bool try_reflink, uint
         unlink(fn3);
 }
 
+static bool fd_supports_holes(int fd, size_t sz) {
+        /* A file that was only extended with ftruncate() is one big hole, if the file system knows about holes
+         * at all. Otherwise SEEK_HOLE reports the end of the file. */
+
+        if (ftruncate(fd, sz) < 0)
+                return false;
+
+        return lseek(fd, 0, SEEK_HOLE) == 0;
+}
+
+static void test_copy_bytes_sparse(uint64_t max_bytes) {
+        char fn[] = "/tmp/test-copy-sparse-XXXXXX", fn2[] = "/tmp/test-copy-sparse-XXXXXX", fn3[] = "/tmp/test-copy-sparse-XXXXXX";
+        _cleanup_close_ int fd = -1, fd2 = -1, fd3 = -1;
+        _cleanup_free_ uint8_t *buf = NULL, *buf2 = NULL;
+        size_t ps, sz;
+        struct stat st;
+        int r;
+
+        log_info("%s max_bytes=%" PRIu64, __func__, max_bytes);
+
+        /* A page of data, two pages of zeroes, a partial page of data, and a trailing page of zeroes */
+        ps = page_size();
+        sz = 4 * ps + ps / 2;
+
+        assert_se(buf = malloc0(sz));
+        memset(buf, 'a', ps);
+        memset(buf + 3 * ps, 'b', ps / 2);
+
+        fd = mkostemp_safe(fn);
+        assert_se(fd >= 0);
+        assert_se(loop_write(fd, buf, sz, false) == 0);
+        assert_se(lseek(fd, 0, SEEK_SET) == 0);
+
+        fd2 = mkostemp_safe(fn2);
+        assert_se(fd2 >= 0);
+
+        r = copy_bytes(fd, fd2, max_bytes, COPY_SPARSE);
+        assert_se(r == (max_bytes < sz));
+
+        assert_se(fstat(fd2, &st) >= 0);
+        assert_se((uint64_t) st.st_size == MIN((uint64_t) sz, max_bytes));
+
+        assert_se(buf2 = malloc(st.st_size));
+        assert_se(pread(fd2, buf2, st.st_size, 0) == st.st_size);
+        assert_se(memcmp(buf, buf2, st.st_size) == 0);
+
+        /* The second page is zero in all cases, hence the copy must not have written it out */
+        fd3 = mkostemp_safe(fn3);
+        assert_se(fd3 >= 0);
+        if (fd_supports_holes(fd3, sz))
+                assert_se(lseek(fd2, 0, SEEK_HOLE) < st.st_size);
+        else
+                log_info("File system doesn't support holes, not checking whether the copy is sparse.");
+
+        unlink(fn);
+        unlink(fn2);
+        unlink(fn3);
+}
+
 static void test_copy_atomic(void) {
         _cleanup_(rm_rf_physical_and_freep) char *p = NULL;
         const char *q;
@@ -268,6 +329,9 @@ int main(int argc, char *argv[]) {
         test_copy_bytes_regular_file(argv[0], true, 1000);
         test_copy_bytes_regular_file(argv[0], false, 32000); /* larger than copy buffer size */
         test_copy_bytes_regular_file(argv[0], true, 32000);
+        test_copy_bytes_sparse((uint64_t) -1);
+        test_copy_bytes_sparse(page_size() * 2); /* ends in a hole */
+        test_copy_bytes_sparse(page_size() * 3 + 10);
         test_copy_atomic();
 
         return 0;
@@ -7,9 +7,67 @@
 #include "bus-util.h"
 #include "manager.h"
 #include "rm-rf.h"
+#include "service.h"
+#include "stdio-util.h"
 #include "test-helper.h"
 #include "tests.h"
 
+static Unit *new_loaded_service(Manager *m, const char *name) {
+        Unit *u;
+
+        assert_se(u = unit_new(m, sizeof(Service)));
+        assert_se(unit_add_name(u, name) >= 0);
+        u->load_state = UNIT_LOADED;
+
+        return u;
+}
+
+static void test_large_transaction(Manager *m) {
+        bool slow = slow_tests_enabled();
+        unsigned i, n_units = slow ? 20000 : 500;
+        char b[FORMAT_TIMESPAN_MAX];
+        Unit *base, *top;
+        usec_t ts;
+        Job *j;
+
+        log_info("/* %s (%s) */", __func__, slow ? "slow" : "fast");
+
+        /* A generated graph of services which all require and are ordered after one base service, and are all
+         * pulled in by one top service. The graph is wide rather than deep: the transaction code verifies the
+         * ordering recursively, hence a long After= chain would only measure the stack depth. */
+
+        base = new_loaded_service(m, "large-transaction-base.service");
+        top = new_loaded_service(m, "large-transaction-top.service");
+
+        for (i = 0; i < n_units; i++) {
+                char name[STRLEN("large-transaction-.service") + DECIMAL_STR_MAX(unsigned)];
+                Unit *u;
+
+                xsprintf(name, "large-transaction-%u.service", i);
+                u = new_loaded_service(m, name);
+
+                assert_se(unit_add_two_dependencies(u, UNIT_AFTER, UNIT_REQUIRES, base, true, UNIT_DEPENDENCY_FILE) >= 0);
+                assert_se(unit_add_dependency(top, UNIT_WANTS, u, true, UNIT_DEPENDENCY_FILE) >= 0);
+        }
+
+        manager_clear_jobs(m);
+
+        ts = now(CLOCK_MONOTONIC);
+        assert_se(manager_add_job(m, JOB_START, top, JOB_REPLACE, NULL, NULL, &j) == 0);
+        assert_se(hashmap_size(m->jobs) == n_units + 2);
+        log_info("Starting %u units took %s", n_units + 2, format_timespan(b, sizeof b, now(CLOCK_MONOTONIC) - ts, 0));
+
+        manager_clear_jobs(m);
+
+        /* None of the units is running, hence all stop jobs but the anchor are dropped as redundant */
+        ts = now(CLOCK_MONOTONIC);
+        assert_se(manager_add_job(m, JOB_STOP, base, JOB_REPLACE, NULL, NULL, &j) == 0);
+        assert_se(hashmap_size(m->jobs) == 1);
+        log_info("Stopping %u units took %s", n_units + 1, format_timespan(b, sizeof b, now(CLOCK_MONOTONIC) - ts, 0));
+
+        manager_clear_jobs(m);
+}
+
 int main(int argc, char *argv[]) {
         _cleanup_(rm_rf_physical_and_freep) char *runtime_dir = NULL;
         _cleanup_(sd_bus_error_free) sd_bus_error err = SD_BUS_ERROR_NULL;
@@ -126,5 +184,7 @@ int main(int argc, char *argv[]) {
         assert_se(strv_equal(unit_with_multiple_dashes->documentation, STRV_MAKE("man:test", "man:override2", "man:override3")));
         assert_se(streq_ptr(unit_with_multiple_dashes->description, "override4"));
 
+        test_large_transaction(m);
+
         return 0;
 }
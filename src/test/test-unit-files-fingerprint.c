@@ -0,0 +1,150 @@
+/* SPDX-License-Identifier: LGPL-2.1+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fileio.h"
+#include "manager.h"
+#include "path-util.h"
+#include "rm-rf.h"
+#include "test-helper.h"
+#include "tests.h"
+#include "tmpfile-util.h"
+
+static uint64_t fingerprint(Manager *m, bool *ret_trusted) {
+        uint64_t f;
+        bool trusted;
+
+        assert_se(manager_unit_files_fingerprint(m, &f, &trusted) >= 0);
+        if (ret_trusted)
+                *ret_trusted = trusted;
+
+        return f;
+}
+
+static void touch_old(const char *dir, const char *name, usec_t t) {
+        _cleanup_free_ char *p = NULL;
+        struct timespec ts[2];
+
+        /* Sets the mtime to a fixed point in the past, so that it changes even if the file system has
+         * a coarse timestamp granularity */
+        assert_se(p = path_join(dir, name));
+        timespec_store(&ts[0], t);
+        ts[1] = ts[0];
+        assert_se(utimensat(AT_FDCWD, p, ts, 0) >= 0);
+}
+
+static void test_fingerprint_changes(Manager *m, const char *dir) {
+        const char *c, *d, *wants_d, *wants_e;
+        uint64_t f, g;
+        bool trusted;
+
+        log_info("/* %s */", __func__);
+
+        c = strjoina(dir, "/c.service");
+        d = strjoina(dir, "/d.service");
+        wants_d = strjoina(dir, "/a.service.wants/d.service");
+        wants_e = strjoina(dir, "/a.service.wants/e.service");
+
+        f = fingerprint(m, &trusted);
+        assert_se(fingerprint(m, NULL) == f);
+
+        /* All files were just written */
+        assert_se(!trusted);
+
+        touch_old(dir, "a.service", USEC_PER_SEC);
+        g = fingerprint(m, NULL);
+        assert_se(g != f);
+        f = g;
+
+        assert_se(write_string_file(c, "[Service]\nExecStart=/bin/true\n", WRITE_STRING_FILE_CREATE) >= 0);
+        g = fingerprint(m, NULL);
+        assert_se(g != f);
+        f = g;
+
+        assert_se(rename(c, d) >= 0);
+        g = fingerprint(m, NULL);
+        assert_se(g != f);
+        f = g;
+
+        assert_se(symlink("../d.service", wants_d) >= 0);
+        g = fingerprint(m, NULL);
+        assert_se(g != f);
+        f = g;
+
+        assert_se(rename(wants_d, wants_e) >= 0);
+        g = fingerprint(m, NULL);
+        assert_se(g != f);
+        f = g;
+
+        touch_old(dir, "a.service.wants/e.service", USEC_PER_SEC);
+        g = fingerprint(m, NULL);
+        assert_se(g != f);
+}
+
+static void test_reload_needed(Manager *m, const char *dir) {
+        log_info("/* %s */", __func__);
+
+        /* Nothing recorded yet */
+        assert_se(!m->unit_files_fingerprint_valid);
+        assert_se(manager_reload_needed(m));
+
+        /* The files were just changed, hence the fingerprint cannot be trusted */
+        manager_update_unit_files_fingerprint(m);
+        assert_se(!m->unit_files_fingerprint_valid);
+        assert_se(manager_reload_needed(m));
+
+        /* Once they have settled, it can */
+        assert_se(usleep(UNIT_FILES_SETTLE_USEC + 100 * USEC_PER_MSEC) >= 0);
+        manager_update_unit_files_fingerprint(m);
+        assert_se(m->unit_files_fingerprint_valid);
+        assert_se(!manager_reload_needed(m));
+
+        touch_old(dir, "b.service", 2 * USEC_PER_SEC);
+        assert_se(manager_reload_needed(m));
+
+        /* A fingerprint taken right after a change is not trusted, even though it matches */
+        manager_update_unit_files_fingerprint(m);
+        assert_se(!m->unit_files_fingerprint_valid);
+        assert_se(manager_reload_needed(m));
+}
+
+int main(int argc, char *argv[]) {
+        _cleanup_(rm_rf_physical_and_freep) char *runtime_dir = NULL, *unit_dir = NULL;
+        _cleanup_(manager_freep) Manager *m = NULL;
+        const char *p;
+        int r;
+
+        test_setup_logging(LOG_INFO);
+
+        r = enter_cgroup_subroot();
+        if (r == -ENOMEDIUM)
+                return log_tests_skipped("cgroupfs not available");
+
+        assert_se(mkdtemp_malloc("/tmp/test-unit-files-fingerprint-XXXXXX", &unit_dir) >= 0);
+
+        p = strjoina(unit_dir, "/a.service");
+        assert_se(write_string_file(p, "[Service]\nExecStart=/bin/true\n", WRITE_STRING_FILE_CREATE) >= 0);
+        p = strjoina(unit_dir, "/b.service");
+        assert_se(write_string_file(p, "[Service]\nExecStart=/bin/true\n", WRITE_STRING_FILE_CREATE) >= 0);
+        p = strjoina(unit_dir, "/a.service.wants");
+        assert_se(mkdir(p, 0755) >= 0);
+        p = strjoina(unit_dir, "/a.service.wants/b.service");
+        assert_se(symlink("../b.service", p) >= 0);
+
+        assert_se(set_unit_path(unit_dir) >= 0);
+        assert_se(runtime_dir = setup_fake_runtime_dir());
+
+        r = manager_new(UNIT_FILE_USER, MANAGER_TEST_RUN_BASIC, &m);
+        if (MANAGER_SKIP_TEST(r))
+                return log_tests_skipped_errno(r, "manager_new");
+        assert_se(r >= 0);
+        assert_se(manager_startup(m, NULL, NULL) >= 0);
+
+        test_fingerprint_changes(m, unit_dir);
+        test_reload_needed(m, unit_dir);
+
+        return 0;
+}
@@ -0,0 +1,133 @@
+/* SPDX-License-Identifier: LGPL-2.1+ */
+
+#include "sd-bus.h"
+
+#include "dbus-manager.h"
+#include "hashmap.h"
+#include "manager.h"
+#include "rm-rf.h"
+#include "service.h"
+#include "set.h"
+#include "test-helper.h"
+#include "tests.h"
+#include "unit.h"
+
+static Unit *new_loaded_service(Manager *m, const char *name) {
+        Unit *u;
+
+        assert_se(u = unit_new(m, sizeof(Service)));
+        assert_se(unit_add_name(u, name) >= 0);
+        u->load_state = UNIT_LOADED;
+
+        return u;
+}
+
+static void assert_batch_armed(Manager *m, bool armed) {
+        uint64_t accuracy;
+        int enabled;
+
+        if (!armed && !m->dbus_batch_event_source)
+                return;
+
+        assert_se(m->dbus_batch_event_source);
+        assert_se(sd_event_source_get_enabled(m->dbus_batch_event_source, &enabled) >= 0);
+        assert_se((enabled != SD_EVENT_OFF) == armed);
+
+        /* The default accuracy of sd-event would stretch the window by up to 250ms */
+        assert_se(sd_event_source_get_time_accuracy(m->dbus_batch_event_source, &accuracy) >= 0);
+        assert_se(accuracy > 0 && accuracy < 100 * USEC_PER_MSEC);
+}
+
+static void test_units_changed_batching(Manager *m, sd_bus *bus) {
+        _cleanup_free_ char *path = NULL;
+        const char *unique;
+        Unit *a, *b;
+
+        log_info("/* %s */", __func__);
+
+        a = new_loaded_service(m, "units-changed-a.service");
+        b = new_loaded_service(m, "units-changed-b.service");
+
+        /* Nothing is collected without batched subscribers */
+        bus_manager_queue_unit_changed(m, a);
+        assert_se(set_isempty(m->dbus_batched_units));
+        assert_batch_armed(m, false);
+
+        /* Subscribe ourselves, so that the manager has a batched subscriber to collect changes for */
+        assert_se(sd_bus_track_new(bus, &m->subscribed_batched, NULL, NULL) >= 0);
+        assert_se(sd_bus_get_unique_name(bus, &unique) >= 0);
+        assert_se(sd_bus_track_add_name(m->subscribed_batched, unique) >= 0);
+        assert_se(sd_bus_track_count(m->subscribed_batched) > 0);
+
+        /* Repeated changes of the same unit are merged */
+        bus_manager_queue_unit_changed(m, a);
+        bus_manager_queue_unit_changed(m, a);
+        bus_manager_queue_unit_changed(m, b);
+        assert_se(set_size(m->dbus_batched_units) == 2);
+        assert_se(set_contains(m->dbus_batched_units, a));
+        assert_se(set_contains(m->dbus_batched_units, b));
+        assert_se(hashmap_isempty(m->dbus_batched_removed));
+        assert_batch_armed(m, true);
+
+        /* A removed unit is reported as removed only */
+        bus_manager_queue_unit_removed(m, a);
+        assert_se(set_size(m->dbus_batched_units) == 1);
+        assert_se(!set_contains(m->dbus_batched_units, a));
+        assert_se(hashmap_size(m->dbus_batched_removed) == 1);
+        assert_se(path = unit_dbus_path(a));
+        assert_se(streq_ptr(hashmap_get(m->dbus_batched_removed, a->id), path));
+
+        /* … and one that is removed and comes back within the same window is reported as changed */
+        bus_manager_queue_unit_changed(m, a);
+        assert_se(set_size(m->dbus_batched_units) == 2);
+        assert_se(set_contains(m->dbus_batched_units, a));
+        assert_se(hashmap_isempty(m->dbus_batched_removed));
+
+        /* Flushing clears everything and disarms the timer */
+        bus_manager_queue_unit_removed(m, b);
+        assert_se(hashmap_size(m->dbus_batched_removed) == 1);
+        bus_manager_flush_units_changed(m);
+        assert_se(set_isempty(m->dbus_batched_units));
+        assert_se(hashmap_isempty(m->dbus_batched_removed));
+        assert_batch_armed(m, false);
+
+        /* The next change starts a new window */
+        bus_manager_queue_unit_changed(m, a);
+        assert_se(set_size(m->dbus_batched_units) == 1);
+        assert_batch_armed(m, true);
+        bus_manager_flush_units_changed(m);
+
+        /* The manager expects the subscriber list to go away with its API bus */
+        m->subscribed_batched = sd_bus_track_unref(m->subscribed_batched);
+}
+
+int main(int argc, char *argv[]) {
+        _cleanup_(rm_rf_physical_and_freep) char *runtime_dir = NULL;
+        _cleanup_(sd_bus_flush_close_unrefp) sd_bus *bus = NULL;
+        _cleanup_(manager_freep) Manager *m = NULL;
+        int r;
+
+        test_setup_logging(LOG_INFO);
+
+        r = sd_bus_open_user(&bus);
+        if (r < 0)
+                r = sd_bus_open_system(&bus);
+        if (r < 0)
+                return log_tests_skipped("Failed to connect to bus");
+
+        r = enter_cgroup_subroot();
+        if (r == -ENOMEDIUM)
+                return log_tests_skipped("cgroupfs not available");
+
+        assert_se(set_unit_path(get_testdata_dir()) >= 0);
+        assert_se(runtime_dir = setup_fake_runtime_dir());
+        r = manager_new(UNIT_FILE_USER, MANAGER_TEST_RUN_BASIC, &m);
+        if (MANAGER_SKIP_TEST(r))
+                return log_tests_skipped_errno(r, "manager_new");
+        assert_se(r >= 0);
+        assert_se(manager_startup(m, NULL, NULL) >= 0);
+
+        test_units_changed_batching(m, bus);
+
+        return 0;
+}
@@ -0,0 +1,34 @@
+#!/bin/bash
+# -*- mode: shell-script; indent-tabs-mode: nil; sh-basic-offset: 4; -*-
+# ex: ts=8 sw=4 sts=4 et filetype=sh
+set -ex
+set -o pipefail
+
+get_units_accounting() {
+    busctl call org.freedesktop.systemd1 /org/freedesktop/systemd1 org.freedesktop.systemd1.Manager \
+           GetUnitsAccounting as "$#" "$@"
+}
+
+systemd-run --unit=accounting-test.service -p TasksAccounting=yes sleep infinity
+
+# Only units matching the patterns are returned, one record each
+get_units_accounting 'accounting-test.*' | grep -q '^a(sttttttt) 1 "accounting-test.service" '
+get_units_accounting 'nonexistent-*.service' | grep -q '^a(sttttttt) 0$'
+
+# Without patterns all units with a cgroup are returned
+get_units_accounting | grep -q '"accounting-test.service"'
+get_units_accounting | grep -q '"init.scope"'
+! (get_units_accounting | grep -q '"basic.target"')
+
+# The values match the properties, and IP accounting wasn't enabled
+set -- $(get_units_accounting accounting-test.service)
+[[ "$6" = "$(systemctl show -p TasksCurrent --value accounting-test.service)" ]]
+[[ "$6" = 1 ]]
+[[ "$7" = 18446744073709551615 ]]
+[[ "${10}" = 18446744073709551615 ]]
+
+systemctl stop accounting-test.service
+
+echo OK > /testok
+
+exit 0